@@ -1,10 +1,18 @@
 #include "fhiclcpp/DatabaseSupport.h"
 
 #include "cetlib/filepath_maker.h"
+#include "cetlib/sqlite/Transaction.h"
+#include "cetlib/sqlite/exec.h"
 #include "fhiclcpp/ParameterSet.h"
 #include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/detail/sqlite_session.h"
+
+#include "sqlite3.h"
 
 #include <cassert>
+#include <unordered_set>
+
+using fhicl::detail::throwOnSQLiteFailure;
 
 void
 fhicl::decompose_fhicl(std::string const& filename,
@@ -17,35 +25,40 @@ fhicl::decompose_fhicl(std::string const& filename,
   decompose_parameterset(top, records, hashes);
 }
 
+void
+fhicl::decompose_parameterset(fhicl::ParameterSet const& top,
+                              record_sink const& sink)
+{
+  // Each distinct ParameterSet, and so everything nested in it, is
+  // visited only once, however many times it appears.
+  std::unordered_set<ParameterSetID, detail::HashParameterSetID> seen;
+  auto visit = [&sink, &seen](auto const& self,
+                              ParameterSetID const& id,
+                              ParameterSet const& ps) -> void {
+    if (!seen.insert(id).second) {
+      return;
+    }
+    sink(id.to_string(), ps.to_compact_string());
+    ps.for_each_nested_table(
+      [&self](ParameterSetID const& nested_id, ParameterSet const& nested) {
+        self(self, nested_id, nested);
+      });
+  };
+  visit(visit, top.id(), top);
+}
+
 void
 fhicl::decompose_parameterset(fhicl::ParameterSet const& top,
                               std::vector<std::string>& records,
                               std::vector<std::string>& hashes)
 {
   assert(records.size() == hashes.size());
-
-  // First handle the top-level ParameterSet
-  records.push_back(top.to_compact_string());
-  hashes.push_back(top.id().to_string());
-
-  // Recurse through all parameters, dealing with ParameterSets and
-  // vectors thereof.
-  std::vector<std::string> keys = top.get_names();
-  for (auto const& key : keys) {
-    if (top.is_key_to_table(key))
-      decompose_parameterset(top.get<ParameterSet>(key), records, hashes);
-    else if (top.is_key_to_sequence(key)) {
-      try {
-        auto nestlings = top.get<std::vector<ParameterSet>>(key);
-        for (auto const& ps : nestlings)
-          decompose_parameterset(ps, records, hashes);
-      }
-      catch (fhicl::exception const&) {
-        // The vector didn't contain ParameterSets, keep going; no
-        // corrective action is needed.
-      }
-    }
-  }
+  decompose_parameterset(top,
+                         [&records, &hashes](std::string const& hash,
+                                             std::string const& record) {
+                           records.push_back(record);
+                           hashes.push_back(hash);
+                         });
 }
 
 void
@@ -53,6 +66,28 @@ fhicl::parse_file_and_fill_db(std::string const& filename, sqlite3* out)
 {
   cet::filepath_maker fpm;
   auto const top = ParameterSet::make(filename, fpm);
-  fhicl::ParameterSetRegistry::put(top);
-  fhicl::ParameterSetRegistry::exportTo(out);
+
+  // The records are written as they are produced, in the form used by
+  // ParameterSetRegistry::exportTo.
+  cet::sqlite::Transaction txn{out};
+  cet::sqlite::exec(out,
+                    "DROP TABLE IF EXISTS ParameterSets;"
+                    "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);");
+  detail::sqlite_session session{out};
+  auto* const stmt = session.statement(
+    "INSERT OR IGNORE INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);");
+  decompose_parameterset(
+    top, [out, stmt](std::string const& hash, std::string const& record) {
+      sqlite3_bind_text(stmt, 1, hash.c_str(), hash.size() + 1, SQLITE_STATIC);
+      throwOnSQLiteFailure(out);
+      sqlite3_bind_text(
+        stmt, 2, record.c_str(), record.size() + 1, SQLITE_STATIC);
+      throwOnSQLiteFailure(out);
+      if (sqlite3_step(stmt) != SQLITE_DONE) {
+        throwOnSQLiteFailure(out);
+      }
+      sqlite3_reset(stmt);
+    });
+  session.finalize();
+  txn.commit();
 }
@@ -1,6 +1,7 @@
 #ifndef fhiclcpp_DatabaseSupport_h
 #define fhiclcpp_DatabaseSupport_h
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -9,10 +10,21 @@
 struct sqlite3;
 
 namespace fhicl {
+  // Receives the (string form of the) hash and the "database form" of
+  // one ParameterSet.
+  using record_sink =
+    std::function<void(std::string const& hash, std::string const& record)>;
+
+  // Given a ParameterSet, pass to 'sink' the record of top, and of
+  // each distinct ParameterSet nested in it, once each, parents
+  // before their children.
+  void decompose_parameterset(fhicl::ParameterSet const& top,
+                              record_sink const& sink);
+
   // Given a ParameterSet, return two vectors of strings:
   //
   //   records: will contain the "database form" of top, and of all
-  //            nested ParameterSets.
+  //            distinct nested ParameterSets.
   //
   //   hashes: will contain the (string form) of the hash for each
   //           ParameterSet in 'records', in the same order.
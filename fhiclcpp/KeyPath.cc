@@ -0,0 +1,57 @@
+// ======================================================================
+//
+// KeyPath
+//
+// ======================================================================
+
+#include "fhiclcpp/KeyPath.h"
+#include "fhiclcpp/exception.h"
+
+#include <exception>
+
+using namespace fhicl;
+using namespace fhicl::detail;
+
+namespace {
+  SequenceKey
+  parse_component(std::string const& key, std::string const& component)
+  try {
+    return get_sequence_indices(component);
+  }
+  catch (std::exception const& e) {
+    throw fhicl::exception(error::parse_error, "Malformed key:")
+      << " '" << key << "' (" << e.what() << ")\n";
+  }
+
+  std::vector<SequenceKey>
+  parse_tables(std::string const& key, Keys const& keys)
+  {
+    std::vector<SequenceKey> result;
+    result.reserve(keys.tables().size());
+    for (auto const& table : keys.tables()) {
+      result.push_back(parse_component(key, table));
+    }
+    return result;
+  }
+}
+
+// ----------------------------------------------------------------------
+
+KeyPath::KeyPath(std::string const& key) : KeyPath{key, get_names(key)} {}
+
+KeyPath::KeyPath(std::string const& key, Keys const& keys)
+  : key_{key}
+  , tables_{parse_tables(key, keys)}
+  , last_{parse_component(key, keys.last())}
+  , last_key_{keys.last()}
+{}
+
+// ----------------------------------------------------------------------
+
+std::ostream&
+fhicl::operator<<(std::ostream& os, KeyPath const& key)
+{
+  return os << key.to_string();
+}
+
+// ======================================================================
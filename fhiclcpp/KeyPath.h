@@ -0,0 +1,83 @@
+#ifndef fhiclcpp_KeyPath_h
+#define fhiclcpp_KeyPath_h
+
+// ======================================================================
+//
+// KeyPath: a (possibly nested) ParameterSet key that is split into its
+//          table names and sequence indices once, at construction.
+//
+// A KeyPath may be stored and handed to any of the ParameterSet
+// retrievers in place of the equivalent std::string key; the lookup
+// then performs no further parsing or string allocation:
+//
+//   fhicl::KeyPath const label{"physics.producers.foo.label"};
+//   for (auto const& pset : psets) {
+//     auto const l = pset.get<std::string>(label);
+//   }
+//
+// ======================================================================
+
+#include "fhiclcpp/detail/ParameterSetImplHelpers.h"
+#include "fhiclcpp/fwd.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace fhicl {
+  std::ostream& operator<<(std::ostream&, KeyPath const&);
+}
+
+class fhicl::KeyPath {
+public:
+  explicit KeyPath(std::string const& key);
+
+  std::string const& to_string() const noexcept;
+
+  // The enclosing tables, outermost first.
+  std::vector<detail::SequenceKey> const& tables() const noexcept;
+
+  // The final component, and its spelling in the original key.
+  detail::SequenceKey const& last() const noexcept;
+  std::string const& last_key() const noexcept;
+
+private:
+  KeyPath(std::string const& key, detail::Keys const& keys);
+
+  std::string key_;
+  std::vector<detail::SequenceKey> tables_;
+  detail::SequenceKey last_;
+  std::string last_key_;
+};
+
+// ======================================================================
+
+inline std::string const&
+fhicl::KeyPath::to_string() const noexcept
+{
+  return key_;
+}
+
+inline std::vector<fhicl::detail::SequenceKey> const&
+fhicl::KeyPath::tables() const noexcept
+{
+  return tables_;
+}
+
+inline fhicl::detail::SequenceKey const&
+fhicl::KeyPath::last() const noexcept
+{
+  return last_;
+}
+
+inline std::string const&
+fhicl::KeyPath::last_key() const noexcept
+{
+  return last_key_;
+}
+
+#endif /* fhiclcpp_KeyPath_h */
+
+// Local Variables:
+// mode: c++
+// End:
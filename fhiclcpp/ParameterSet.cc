@@ -12,12 +12,16 @@
 #include "fhiclcpp/detail/Prettifier.h"
 #include "fhiclcpp/detail/PrettifierAnnotated.h"
 #include "fhiclcpp/detail/PrettifierPrefixAnnotated.h"
+#include "fhiclcpp/detail/binary_codec.h"
 #include "fhiclcpp/extended_value.h"
 #include "fhiclcpp/intermediate_table.h"
 #include "fhiclcpp/parse.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <stack>
+#include <string_view>
 
 using namespace fhicl;
 using namespace fhicl::detail;
@@ -54,12 +58,19 @@ namespace {
     }
   }
 
-  ParameterSet const&
-  get_pset_via_any(std::any const& a)
-  {
-    ParameterSetID const& psid = std::any_cast<ParameterSetID>(a);
-    return ParameterSetRegistry::get(psid);
-  }
+  std::atomic<bool> shared_nested_tables_{false};
+}
+
+void
+fhicl::ParameterSet::set_shared_nested_tables(bool const enable) noexcept
+{
+  shared_nested_tables_ = enable;
+}
+
+bool
+fhicl::ParameterSet::shared_nested_tables() noexcept
+{
+  return shared_nested_tables_;
 }
 
 // ----------------------------------------------------------------------
@@ -67,11 +78,14 @@ namespace {
 fhicl::ParameterSet
 fhicl::ParameterSet::make(intermediate_table const& tbl)
 {
+  // The nested tables are registered together once all are built.
+  detail::registration_batch batch;
   ParameterSet result;
   for (auto const& [key, value] : tbl) {
     if (!value.in_prolog)
       result.put(key, value);
   }
+  batch.commit();
   return result;
 }
 
@@ -83,12 +97,14 @@ fhicl::ParameterSet::make(extended_value const& xval)
   if (!xval.is_a(TABLE))
     throw fhicl::exception(type_mismatch, "extended value not a table");
 
+  detail::registration_batch batch;
   ParameterSet result;
   auto const& tbl = table_t(xval);
   for (auto const& [key, value] : tbl) {
     if (!value.in_prolog)
       result.put(key, value);
   }
+  batch.commit();
   return result;
 }
 
@@ -118,10 +134,12 @@ ParameterSet::stringify_(any const& a, bool const compact) const
 {
   string result;
   if (is_table(a)) {
-    auto const& psid = any_cast<ParameterSetID>(a);
-    result = '{' + ParameterSetRegistry::get(psid).to_string() + '}';
+    result = '{' + get_table(a)->to_string() + '}';
     if (compact && result.size() > (5 + ParameterSetID::max_str_size())) {
-      // Replace with a reference to the ParameterSetID;
+      // Replace with a reference to the ParameterSetID, which must then
+      // be resolvable via the registry.
+      ParameterSetID psid;
+      decode(a, psid);
       result = std::string("@id::") + psid.to_string();
     }
   } else if (is_sequence(a)) {
@@ -143,6 +161,269 @@ ParameterSet::stringify_(any const& a, bool const compact) const
 
 // ----------------------------------------------------------------------
 
+// Feeds the canonical string of a ParameterSet to the SHA-1 hasher
+// through a fixed-size buffer.  The digest has always been that of
+// the C string of to_string(), so everything from the first NUL
+// character on is ignored.
+class fhicl::ParameterSet::digest_sink {
+public:
+  digest_sink() { buffer_.reserve(capacity); }
+
+  digest_sink&
+  operator<<(std::string const& str)
+  {
+    if (done_) {
+      return *this;
+    }
+    auto const pos = str.find('\0');
+    done_ = pos != string::npos;
+    auto const n = done_ ? pos : str.size();
+    if (buffer_.size() + n > capacity) {
+      flush_();
+    }
+    if (n > capacity) {
+      sha_ << (done_ ? str.substr(0, n) : str);
+    } else {
+      buffer_.append(str, 0, n);
+    }
+    return *this;
+  }
+
+  digest_sink&
+  operator<<(char const c)
+  {
+    if (c == '\0') {
+      done_ = true;
+    } else if (!done_) {
+      if (buffer_.size() == capacity) {
+        flush_();
+      }
+      buffer_.push_back(c);
+    }
+    return *this;
+  }
+
+  bool
+  done() const noexcept
+  {
+    return done_;
+  }
+
+  cet::sha1::digest_t
+  digest()
+  {
+    flush_();
+    return sha_.digest();
+  }
+
+private:
+  static constexpr std::size_t capacity{4096};
+
+  void
+  flush_()
+  {
+    if (!buffer_.empty()) {
+      sha_ << buffer_;
+      buffer_.clear();
+    }
+  }
+
+  cet::sha1 sha_;
+  std::string buffer_;
+  bool done_{false};
+};
+
+cet::sha1::digest_t
+ParameterSet::digest_() const
+{
+  digest_sink sink;
+  write_canonical_(sink);
+  return sink.digest();
+}
+
+// Mirrors to_string_(false).
+void
+ParameterSet::write_canonical_(digest_sink& sink) const
+{
+  bool first{true};
+  for (auto const& [key, value] : mapping_) {
+    if (sink.done()) {
+      return;
+    }
+    if (!first) {
+      sink << ' ';
+    }
+    first = false;
+    sink << key << ':';
+    write_canonical_(sink, value.value());
+  }
+}
+
+// Mirrors stringify_(a, false).
+void
+ParameterSet::write_canonical_(digest_sink& sink, any const& a) const
+{
+  if (is_table(a)) {
+    sink << '{';
+    get_table(a)->write_canonical_(sink);
+    sink << '}';
+  } else if (is_sequence(a)) {
+    auto const& seq = any_cast<ps_sequence_t const&>(a);
+    sink << '[';
+    bool first{true};
+    for (auto const& element : seq) {
+      if (sink.done()) {
+        return;
+      }
+      if (!first) {
+        sink << ',';
+      }
+      first = false;
+      write_canonical_(sink, element);
+    }
+    sink << ']';
+  } else { // is_atom(a)
+    static string const nil_value(9, '\0');
+    static string const nil_text{"@nil"};
+    auto const& str = any_cast<ps_atom_t const&>(a);
+    sink << (str == nil_value ? nil_text : str);
+  }
+}
+
+// ----------------------------------------------------------------------
+// Binary serialization, version 1:
+//
+//   bytes   := magic version table
+//   magic   := "\x7fFHB" (which cannot begin a FHiCL document)
+//   version := 1 byte
+//   table   := count (string value)*      entries in key order
+//   value   := 'a' string                 atom, in canonical form
+//            | 's' count value*           sequence
+//            | 't' digest                 table, by its ParameterSetID
+//   string  := count byte*
+//   count   := unsigned LEB128
+//   digest  := the 20 bytes of the SHA-1 digest
+
+namespace {
+  constexpr std::string_view binary_magic{"\x7f"
+                                          "FHB"};
+  constexpr unsigned char binary_version{1};
+
+  void
+  write_binary_value(std::string& out, any const& a)
+  {
+    if (is_table(a)) {
+      ParameterSetID id;
+      decode(a, id);
+      out.push_back('t');
+      auto const& digest = id.digest();
+      out.append(reinterpret_cast<char const*>(digest.data()), digest.size());
+    } else if (is_sequence(a)) {
+      auto const& seq = any_cast<ps_sequence_t const&>(a);
+      out.push_back('s');
+      write_count(out, seq.size());
+      for (auto const& element : seq) {
+        write_binary_value(out, element);
+      }
+    } else { // is_atom(a)
+      out.push_back('a');
+      write_bytes(out, any_cast<ps_atom_t const&>(a));
+    }
+  }
+}
+
+bool
+ParameterSet::is_binary(std::string_view const bytes) noexcept
+{
+  return bytes.starts_with(binary_magic);
+}
+
+void
+ParameterSet::write_binary_(std::string& out) const
+{
+  if (out.empty()) {
+    out.append(binary_magic);
+    out.push_back(static_cast<char>(binary_version));
+  }
+  write_count(out, mapping_.size());
+  for (auto const& [key, value] : mapping_) {
+    write_bytes(out, key);
+    write_binary_value(out, value.value());
+  }
+}
+
+class fhicl::ParameterSet::binary_reader : detail::binary_decoder {
+public:
+  explicit binary_reader(std::string_view const bytes)
+    : binary_decoder{bytes, "binary ParameterSet: "}
+  {}
+
+  ParameterSet
+  table()
+  {
+    ParameterSet result;
+    for (auto n = count(); n != 0; --n) {
+      auto key = string();
+      // Entries were written in key order, so each is appended.
+      if (!result.mapping_.emplace(std::move(key), value()).second) {
+        fail("duplicate key");
+      }
+    }
+    return result;
+  }
+
+  using binary_decoder::expect_end;
+
+private:
+  any
+  value()
+  {
+    switch (byte()) {
+    case 'a':
+      return string();
+    case 's': {
+      auto n = count();
+      ps_sequence_t seq;
+      seq.reserve(std::min(n, remaining()));
+      for (; n != 0; --n) {
+        seq.push_back(value());
+      }
+      return seq;
+    }
+    case 't': {
+      cet::sha1::digest_t digest;
+      auto const raw = bytes(digest.size());
+      std::copy(raw.begin(), raw.end(), digest.begin());
+      return ParameterSetID{digest};
+    }
+    default:
+      unread();
+      fail("unknown value tag");
+    }
+  }
+};
+
+fhicl::ParameterSet
+fhicl::ParameterSet::make_from_binary(std::string_view const bytes)
+{
+  if (!is_binary(bytes)) {
+    throw exception(parse_error, "binary ParameterSet: ")
+      << "not a binary ParameterSet.\n";
+  }
+  if (bytes.size() == binary_magic.size() ||
+      static_cast<unsigned char>(bytes[binary_magic.size()]) !=
+        binary_version) {
+    throw exception(parse_error, "binary ParameterSet: ")
+      << "unsupported version.\n";
+  }
+  binary_reader reader{bytes.substr(binary_magic.size() + 1)};
+  auto result = reader.table();
+  reader.expect_end();
+  return result;
+}
+
+// ----------------------------------------------------------------------
+
 bool
 ParameterSet::is_empty() const
 {
@@ -167,10 +448,10 @@ ParameterSet::to_string_(bool const compact) const
   }
   auto it = mapping_.begin();
   result.append(it->first).append(1, ':').append(
-    stringify_(it->second, compact));
+    stringify_(it->second.value(), compact));
   for (auto const e = mapping_.end(); ++it != e;) {
     result.append(1, ' ').append(it->first).append(1, ':').append(
-      stringify_(it->second, compact));
+      stringify_(it->second.value(), compact));
   }
   return result;
 }
@@ -190,7 +471,7 @@ ParameterSet::get_pset_names() const
 {
   vector<string> keys;
   for (auto const& [key, value] : mapping_) {
-    if (is_table(value)) {
+    if (is_table(value.value())) {
       keys.push_back(key);
     }
   }
@@ -205,42 +486,58 @@ ParameterSet::get_all_keys() const
   return ka.result();
 }
 
-bool
-ParameterSet::find_one_(std::string const& simple_key) const
+std::any const*
+ParameterSet::lookup_one_(std::string const& simple_key) const
 {
-  auto skey = detail::get_sequence_indices(simple_key);
+  return lookup_one_(detail::get_sequence_indices(simple_key));
+}
 
+std::any const*
+ParameterSet::lookup_one_(SequenceKey const& skey) const
+{
   auto it = mapping_.find(skey.name());
   if (it == mapping_.end()) {
-    return false;
+    return nullptr;
   }
 
-  auto a = it->second;
-  return detail::find_an_any(skey.indices().cbegin(), skey.indices().cend(), a);
+  return detail::find_an_any(
+    skey.indices().cbegin(), skey.indices().cend(), &it->second.value());
+}
+
+bool
+ParameterSet::find_one_(std::string const& simple_key) const
+{
+  return lookup_one_(simple_key) != nullptr;
 }
 
-std::optional<ParameterSet>
-ParameterSet::descend_(std::vector<std::string> const& names) const
+template <class Key>
+detail::table_ref
+ParameterSet::descend_through_(std::vector<Key> const& names) const
 {
-  if (empty(names)) {
-    return std::make_optional(*this);
-  }
-  ParameterSet const* p{this};
-  std::optional<ParameterSet> result;
+  // Walk references to the registry's copies of the nested tables so
+  // that no intermediate ParameterSet is copied.  Each is kept in
+  // memory until the next has been found.
+  detail::table_ref p{*this};
   for (auto const& name : names) {
-    if (!p->find_one_(name)) {
-      return std::nullopt;
-    }
-    if (!p->is_key_to_table(name)) {
-      return std::nullopt;
-    }
-
-    if (result = p->get_one_<ParameterSet>(name); not result) {
-      return std::nullopt;
+    auto const* a = p->lookup_one_(name);
+    if (a == nullptr || !is_table(*a)) {
+      return {};
     }
-    p = &result.value();
+    p = get_table(*a);
   }
-  return result;
+  return p;
+}
+
+detail::table_ref
+ParameterSet::descend_(std::vector<std::string> const& names) const
+{
+  return descend_through_(names);
+}
+
+detail::table_ref
+ParameterSet::descend_(std::vector<SequenceKey> const& names) const
+{
+  return descend_through_(names);
 }
 
 bool
@@ -251,6 +548,13 @@ ParameterSet::has_key(std::string const& key) const
   return ps ? ps->find_one_(keys.last()) : false;
 }
 
+bool
+ParameterSet::has_key(KeyPath const& key) const
+{
+  auto ps = descend_(key.tables());
+  return ps ? ps->lookup_one_(key.last()) != nullptr : false;
+}
+
 // ----------------------------------------------------------------------
 
 std::string
@@ -287,49 +591,59 @@ namespace {
 }
 
 void
-ParameterSet::insert_(string const& key, any const& value)
+ParameterSet::insert_(string const& key, any&& value)
 {
   check_put_local_key(key);
-  if (!mapping_.emplace(key, value).second) {
+  if (!mapping_.emplace(key, std::move(value)).second) {
     throw exception(cant_insert) << "key " << key << " already exists.";
   }
   id_.invalidate();
 }
 
 void
-ParameterSet::insert_or_replace_(string const& key, any const& value)
+ParameterSet::check_insertable_(string const& key) const
+{
+  check_put_local_key(key);
+  if (mapping_.find(key) != mapping_.end()) {
+    throw exception(cant_insert) << "key " << key << " already exists.";
+  }
+}
+
+void
+ParameterSet::insert_or_replace_(string const& key, any&& value)
 {
   check_put_local_key(key);
-  mapping_[key] = value;
+  mapping_[key] = detail::stored_value{std::move(value)};
   id_.invalidate();
 }
 
 void
-ParameterSet::insert_or_replace_compatible_(string const& key, any const& value)
+ParameterSet::insert_or_replace_compatible_(string const& key, any&& value)
 {
   check_put_local_key(key);
   auto item = mapping_.find(key);
   if (item == mapping_.end()) {
-    insert_(key, value);
+    insert_(key, std::move(value));
     return;
   } else {
     if (!detail::is_nil(value)) {
+      auto const& current = item->second.value();
       auto is_non_nil_atom = [](any const& v) {
         return !(detail::is_sequence(v) || detail::is_table(v) ||
                  detail::is_nil(v));
       };
-      if (detail::is_sequence(item->second) && !detail::is_sequence(value)) {
+      if (detail::is_sequence(current) && !detail::is_sequence(value)) {
         throw exception(cant_insert)
           << "can't use non-sequence to replace sequence.";
-      } else if (detail::is_table(item->second) && !detail::is_table(value)) {
+      } else if (detail::is_table(current) && !detail::is_table(value)) {
         throw exception(cant_insert) << "can't use non-table to replace table.";
-      } else if (is_non_nil_atom(item->second) &&
+      } else if (is_non_nil_atom(current) &&
                  (detail::is_sequence(value) || detail::is_table(value))) {
         throw exception(cant_insert)
           << "can't use non-atom to replace non-nil atom.";
       }
     }
-    item->second = value;
+    item->second = detail::stored_value{std::move(value)};
   }
   id_.invalidate();
 }
@@ -352,18 +666,22 @@ ParameterSet::key_is_type_(std::string const& key,
     throw exception(error::cant_find, key);
   }
 
-  auto skey = detail::get_sequence_indices(split_keys.last());
+  auto const* a = ps->lookup_one_(split_keys.last());
+  return a != nullptr ? func(*a) : throw exception(error::cant_find, key);
+}
 
-  auto it = ps->mapping_.find(skey.name());
-  if (it == ps->mapping_.end()) {
-    throw exception(error::cant_find, key);
+bool
+ParameterSet::key_is_type_(KeyPath const& key,
+                           std::function<bool(std::any const&)> func) const
+{
+  auto ps = descend_(key.tables());
+  if (not ps) {
+    throw exception(error::cant_find, key.to_string());
   }
 
-  auto a = it->second;
-  return detail::find_an_any(
-           skey.indices().cbegin(), skey.indices().cend(), a) ?
-           func(a) :
-           throw exception(error::cant_find, key);
+  auto const* a = ps->lookup_one_(key.last());
+  return a != nullptr ? func(*a) :
+                        throw exception(error::cant_find, key.to_string());
 }
 
 // ======================================================================
@@ -432,11 +750,12 @@ ParameterSet::walk(ParameterSetWalker& psw) const
       psw.do_before_action(key, a, ps);
 
       if (is_table(a)) {
-        ParameterSet const* ps = &get_pset_via_any(a);
+        auto const table = get_table(a);
+        ParameterSet const* ps = &*table;
         ps_stack.push(ps);
         psw.do_enter_table(key, a);
-        for (auto const& [nested_key, nested_a] : ps->mapping_) {
-          act_on_element(nested_key, nested_a);
+        for (auto const& [nested_key, nested_value] : ps->mapping_) {
+          act_on_element(nested_key, nested_value.value());
         }
         psw.do_exit_table(key, a);
         ps_stack.pop();
@@ -456,7 +775,34 @@ ParameterSet::walk(ParameterSetWalker& psw) const
     };
 
   for (auto const& [key, value] : mapping_) {
-    act_on_element(key, value);
+    act_on_element(key, value.value());
+  }
+}
+
+namespace {
+  template <class F>
+  void
+  for_each_table_in(any const& a, F const& f)
+  {
+    if (auto const* id = any_cast<ParameterSetID>(&a)) {
+      f(*id, *get_table(a));
+    } else if (auto const* table = any_cast<shared_table>(&a)) {
+      f(table->id(), table->pset());
+    } else if (auto const* seq = any_cast<ps_sequence_t>(&a)) {
+      for (auto const& element : *seq) {
+        for_each_table_in(element, f);
+      }
+    }
+  }
+}
+
+void
+ParameterSet::for_each_nested_table(
+  std::function<void(ParameterSetID const&, ParameterSet const&)> const& f)
+  const
+{
+  for (auto const& [key, value] : mapping_) {
+    for_each_table_in(value.value(), f);
   }
 }
 
@@ -518,9 +864,13 @@ ParameterSet::to_indented_string(unsigned const initial_indent_level,
 #define _INSTANTIATE_GET(FHICL_TYPE, T)                                        \
   template _DECODE_##FHICL_TYPE##_(T);                                         \
   template _GET_ONE_(T);                                                       \
+  template _GET_ONE_SEQUENCE_KEY_(T);                                          \
   template _GET(T);                                                            \
   template _GET_WITH_DEFAULT(T);                                               \
-  template _GET_IF_PRESENT(T)
+  template _GET_IF_PRESENT(T);                                                 \
+  template _GET_KEY_PATH(T);                                                   \
+  template _GET_KEY_PATH_WITH_DEFAULT(T);                                      \
+  template _GET_KEY_PATH_IF_PRESENT(T)
 
 _INSTANTIATE_GET(ATOM, bool);
 _INSTANTIATE_GET(ATOM, int);
@@ -8,23 +8,30 @@
 // ======================================================================
 
 #include "cetlib_except/demangle.h"
+#include "fhiclcpp/KeyPath.h"
 #include "fhiclcpp/ParameterSetID.h"
 #include "fhiclcpp/coding.h"
 #include "fhiclcpp/detail/ParameterSetImplHelpers.h"
 #include "fhiclcpp/detail/encode_extended_value.h"
+#include "fhiclcpp/detail/flat_map.h"
 #include "fhiclcpp/detail/print_mode.h"
+#include "fhiclcpp/detail/stored_value.h"
 #include "fhiclcpp/detail/try_blocks.h"
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/fwd.h"
 
 #include <any>
+#include <concepts>
 #include <functional>
 #include <map>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <typeinfo>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 // ----------------------------------------------------------------------
@@ -33,6 +40,16 @@ namespace cetlib {
   class filepath_maker;
 }
 
+namespace fhicl::detail {
+  // Values that may be moved into a ParameterSet.  An extended_value
+  // is excluded since its put specialization also records source
+  // information.
+  template <class T>
+  concept movable_parameter =
+    !std::is_reference_v<T> &&
+    !std::same_as<std::remove_cv_t<T>, extended_value>;
+}
+
 class fhicl::ParameterSet {
 public:
   using ps_atom_t = fhicl::detail::ps_atom_t;
@@ -46,6 +63,17 @@ public:
   static ParameterSet make(std::string const& str);
   static ParameterSet make(std::string const& filename,
                            cet::filepath_maker& maker);
+  // Reads the output of to_binary_string(), without parsing.
+  static ParameterSet make_from_binary(std::string_view bytes);
+  static bool is_binary(std::string_view bytes) noexcept;
+
+  // Nested tables are by default registered with the
+  // ParameterSetRegistry and held by ParameterSetID.  When enabled,
+  // tables inserted afterwards (including those of parsed documents)
+  // are instead held directly by their parents, and are registered
+  // only when their IDs are needed; see detail::shared_table.
+  static void set_shared_nested_tables(bool enable) noexcept;
+  static bool shared_nested_tables() noexcept;
 
   // observers:
   bool is_empty() const;
@@ -53,6 +81,11 @@ public:
 
   std::string to_string() const;
   std::string to_compact_string() const;
+  // A versioned binary encoding, for storage.  As with
+  // to_compact_string(), nested tables are referred to by
+  // ParameterSetID, and must be resolvable via the
+  // ParameterSetRegistry when read back.
+  std::string to_binary_string() const;
 
   std::string to_indented_string() const;
   std::string to_indented_string(unsigned initial_indent_level) const;
@@ -96,10 +129,45 @@ public:
         T const& default_value,
         T convert(Via const&)) const;
 
+  // retrievers (pre-parsed nested key):
+  bool has_key(KeyPath const& key) const;
+  bool is_key_to_table(KeyPath const& key) const;
+  bool is_key_to_sequence(KeyPath const& key) const;
+  bool is_key_to_atom(KeyPath const& key) const;
+
+  template <class T>
+  std::optional<T> get_if_present(KeyPath const& key) const;
+  template <class T, class Via>
+  std::optional<T> get_if_present(KeyPath const& key,
+                                  T convert(Via const&)) const;
+  template <class T>
+  bool get_if_present(KeyPath const& key, T& value) const;
+  template <class T, class Via>
+  bool get_if_present(KeyPath const& key,
+                      T& value,
+                      T convert(Via const&)) const;
+
+  template <class T>
+  T get(KeyPath const& key) const;
+  template <class T, class Via>
+  T get(KeyPath const& key, T convert(Via const&)) const;
+  template <class T>
+  T get(KeyPath const& key, T const& default_value) const;
+  template <class T, class Via>
+  T get(KeyPath const& key,
+        T const& default_value,
+        T convert(Via const&)) const;
+
   std::string get_src_info(std::string const& key) const;
 
   // Facility to traverse the ParameterSet tree
   void walk(ParameterSetWalker& psw) const;
+  // Calls f for each table held by this one, whether directly or
+  // within (nested) sequences, in key order.  Their own nested tables
+  // are not visited.
+  void for_each_nested_table(
+    std::function<void(ParameterSetID const&, ParameterSet const&)> const& f)
+    const;
 
   // inserters (key must be local: no nesting):
   void put(std::string const& key); // Implicit nil value.
@@ -111,6 +179,17 @@ public:
   template <class T> // Fail if preexisting key of incompatible type.
   void put_or_replace_compatible(std::string const& key, T const& value);
 
+  // inserters taking ownership of the value (key must be local):
+  template <detail::movable_parameter T> // Fail on preexisting key.
+  void put(std::string const& key, T&& value);
+  template <detail::movable_parameter T> // Succeed.
+  void put_or_replace(std::string const& key, T&& value);
+  template <detail::movable_parameter T> // Fail if incompatible.
+  void put_or_replace_compatible(std::string const& key, T&& value);
+  template <detail::movable_parameter T,
+            class... Args> // Fail on preexisting key.
+  void emplace(std::string const& key, Args&&... args);
+
   // deleters:
   bool erase(std::string const& key);
 
@@ -119,7 +198,11 @@ public:
   bool operator!=(ParameterSet const& other) const;
 
 private:
-  using map_t = std::map<std::string, std::any>;
+#ifdef FHICLCPP_STD_MAP_STORAGE
+  using map_t = std::map<std::string, detail::stored_value>;
+#else
+  using map_t = detail::flat_map<std::string, detail::stored_value>;
+#endif
   using map_iter_t = map_t::const_iterator;
 
   map_t mapping_;
@@ -127,23 +210,45 @@ private:
   mutable ParameterSetID id_;
 
   // Private inserters.
-  void insert_(std::string const& key, std::any const& value);
-  void insert_or_replace_(std::string const& key, std::any const& value);
+  void insert_(std::string const& key, std::any&& value);
+  void insert_or_replace_(std::string const& key, std::any&& value);
   void insert_or_replace_compatible_(std::string const& key,
-                                     std::any const& value);
+                                     std::any&& value);
+  void check_insertable_(std::string const& key) const;
 
   std::string to_string_(bool compact = false) const;
   std::string stringify_(std::any const& a, bool compact = false) const;
 
+  // Digest of to_string(), computed without materializing it.
+  friend class ParameterSetID;
+  class digest_sink;
+  cet::sha1::digest_t digest_() const;
+  void write_canonical_(digest_sink& sink) const;
+  void write_canonical_(digest_sink& sink, std::any const& a) const;
+
+  // Binary serialization; see to_binary_string().
+  class binary_reader;
+  void write_binary_(std::string& out) const;
+
   bool key_is_type_(std::string const& key,
                     std::function<bool(std::any const&)> func) const;
+  bool key_is_type_(KeyPath const& key,
+                    std::function<bool(std::any const&)> func) const;
 
   // Local retrieval only.
   template <class T>
   std::optional<T> get_one_(std::string const& key) const;
+  template <class T>
+  std::optional<T> get_one_(detail::SequenceKey const& skey,
+                            std::string const& key) const;
   bool find_one_(std::string const& key) const;
-  std::optional<ParameterSet> descend_(
-    std::vector<std::string> const& names) const;
+  std::any const* lookup_one_(std::string const& key) const;
+  std::any const* lookup_one_(detail::SequenceKey const& skey) const;
+  detail::table_ref descend_(std::vector<std::string> const& names) const;
+  detail::table_ref descend_(
+    std::vector<detail::SequenceKey> const& names) const;
+  template <class Key>
+  detail::table_ref descend_through_(std::vector<Key> const& names) const;
 
 }; // ParameterSet
 
@@ -158,6 +263,10 @@ private:
 #define _GET_ONE_(T)                                                           \
   std::optional<T> fhicl::ParameterSet::get_one_<T>(std::string const&) const
 
+#define _GET_ONE_SEQUENCE_KEY_(T)                                              \
+  std::optional<T> fhicl::ParameterSet::get_one_<T>(                           \
+    fhicl::detail::SequenceKey const&, std::string const&) const
+
 #define _GET(T) T fhicl::ParameterSet::get<T>(std::string const&) const
 
 #define _GET_WITH_DEFAULT(T)                                                   \
@@ -167,12 +276,26 @@ private:
   std::optional<T> fhicl::ParameterSet::get_if_present<T>(std::string const&)  \
     const
 
+#define _GET_KEY_PATH(T)                                                       \
+  T fhicl::ParameterSet::get<T>(fhicl::KeyPath const&) const
+
+#define _GET_KEY_PATH_WITH_DEFAULT(T)                                          \
+  T fhicl::ParameterSet::get<T>(fhicl::KeyPath const&, T const&) const
+
+#define _GET_KEY_PATH_IF_PRESENT(T)                                            \
+  std::optional<T> fhicl::ParameterSet::get_if_present<T>(                     \
+    fhicl::KeyPath const&) const
+
 #define _EXTERN_INSTANTIATE_GET(FHICL_TYPE, T)                                 \
   extern template _DECODE_##FHICL_TYPE##_(T);                                  \
   extern template _GET_ONE_(T);                                                \
+  extern template _GET_ONE_SEQUENCE_KEY_(T);                                   \
   extern template _GET(T);                                                     \
   extern template _GET_WITH_DEFAULT(T);                                        \
-  extern template _GET_IF_PRESENT(T)
+  extern template _GET_IF_PRESENT(T);                                          \
+  extern template _GET_KEY_PATH(T);                                            \
+  extern template _GET_KEY_PATH_WITH_DEFAULT(T);                               \
+  extern template _GET_KEY_PATH_IF_PRESENT(T)
 
 _EXTERN_INSTANTIATE_GET(ATOM, bool);
 _EXTERN_INSTANTIATE_GET(ATOM, int);
@@ -204,6 +327,14 @@ fhicl::ParameterSet::to_compact_string() const
   return to_string_(true);
 }
 
+inline std::string
+fhicl::ParameterSet::to_binary_string() const
+{
+  std::string result;
+  write_binary_(result);
+  return result;
+}
+
 inline bool
 fhicl::ParameterSet::is_key_to_table(std::string const& key) const
 {
@@ -224,6 +355,26 @@ fhicl::ParameterSet::is_key_to_atom(std::string const& key) const
   });
 }
 
+inline bool
+fhicl::ParameterSet::is_key_to_table(KeyPath const& key) const
+{
+  return key_is_type_(key, &detail::is_table);
+}
+
+inline bool
+fhicl::ParameterSet::is_key_to_sequence(KeyPath const& key) const
+{
+  return key_is_type_(key, &detail::is_sequence);
+}
+
+inline bool
+fhicl::ParameterSet::is_key_to_atom(KeyPath const& key) const
+{
+  return key_is_type_(key, [](std::any const& a) {
+    return !(detail::is_sequence(a) || detail::is_table(a));
+  });
+}
+
 template <class T>
 void
 fhicl::ParameterSet::put(std::string const& key, T const& value)
@@ -260,6 +411,66 @@ fhicl::ParameterSet::put_or_replace_compatible(std::string const& key,
   detail::try_insert(insert_or_replace_compatible, key);
 }
 
+template <fhicl::detail::movable_parameter T>
+void
+fhicl::ParameterSet::put(std::string const& key, T&& value)
+{
+  auto insert = [this, &value](auto const& key) {
+    using detail::encode;
+    this->insert_(key, std::any(encode(std::move(value))));
+  };
+  detail::try_insert(insert, key);
+}
+
+template <fhicl::detail::movable_parameter T>
+void
+fhicl::ParameterSet::put_or_replace(std::string const& key, T&& value)
+{
+  auto insert_or_replace = [this, &value](auto const& key) {
+    using detail::encode;
+    this->insert_or_replace_(key, std::any(encode(std::move(value))));
+    srcMapping_.erase(key);
+  };
+  detail::try_insert(insert_or_replace, key);
+}
+
+template <fhicl::detail::movable_parameter T>
+void
+fhicl::ParameterSet::put_or_replace_compatible(std::string const& key,
+                                               T&& value)
+{
+  auto insert_or_replace_compatible = [this, &value](auto const& key) {
+    using detail::encode;
+    this->insert_or_replace_compatible_(key,
+                                        std::any(encode(std::move(value))));
+    srcMapping_.erase(key);
+  };
+  detail::try_insert(insert_or_replace_compatible, key);
+}
+
+template <fhicl::detail::movable_parameter T, class... Args>
+void
+fhicl::ParameterSet::emplace(std::string const& key, Args&&... args)
+{
+  auto insert = [this, &args...](auto const& key) {
+    using detail::encode;
+    // Nothing is built for a key that cannot be inserted.
+    this->check_insertable_(key);
+    T value(std::forward<Args>(args)...);
+    using encoded_t = decltype(encode(std::move(value)));
+    // The encoding is constructed directly in the std::any of the new
+    // entry; a table is encoded as a std::any already.
+    if constexpr (std::same_as<encoded_t, std::any>) {
+      mapping_.try_emplace(key, encode(std::move(value)));
+    } else {
+      mapping_.try_emplace(
+        key, std::in_place_type<encoded_t>, encode(std::move(value)));
+    }
+    id_.invalidate();
+  };
+  detail::try_insert(insert, key);
+}
+
 // ----------------------------------------------------------------------
 
 template <class T>
@@ -345,6 +556,88 @@ fhicl::ParameterSet::get(std::string const& key,
 
 // ----------------------------------------------------------------------
 
+template <class T>
+std::optional<T>
+fhicl::ParameterSet::get_if_present(KeyPath const& key) const
+{
+  if (auto ps = descend_(key.tables())) {
+    return ps->get_one_<T>(key.last(), key.last_key());
+  }
+  return std::nullopt;
+}
+
+template <class T, class Via>
+std::optional<T>
+fhicl::ParameterSet::get_if_present(KeyPath const& key,
+                                    T convert(Via const&)) const
+{
+  auto go_between = get_if_present<Via>(key);
+  if (not go_between) {
+    return std::nullopt;
+  }
+  return std::make_optional(convert(*go_between));
+}
+
+template <class T>
+bool
+fhicl::ParameterSet::get_if_present(KeyPath const& key, T& value) const
+{
+  if (auto present_parameter = get_if_present<T>(key)) {
+    value = *present_parameter;
+    return true;
+  }
+  return false;
+}
+
+template <class T, class Via>
+bool
+fhicl::ParameterSet::get_if_present(KeyPath const& key,
+                                    T& result,
+                                    T convert(Via const&)) const
+{
+  if (auto present_parameter = get_if_present<T>(key, convert)) {
+    result = *present_parameter;
+    return true;
+  }
+  return false;
+}
+
+template <class T>
+T
+fhicl::ParameterSet::get(KeyPath const& key) const
+{
+  auto result = get_if_present<T>(key);
+  return result ? *result : throw fhicl::exception(cant_find, key.to_string());
+}
+
+template <class T, class Via>
+T
+fhicl::ParameterSet::get(KeyPath const& key, T convert(Via const&)) const
+{
+  auto result = get_if_present<T>(key, convert);
+  return result ? *result : throw fhicl::exception(cant_find, key.to_string());
+}
+
+template <class T>
+T
+fhicl::ParameterSet::get(KeyPath const& key, T const& default_value) const
+{
+  auto result = get_if_present<T>(key);
+  return result ? *result : default_value;
+}
+
+template <class T, class Via>
+T
+fhicl::ParameterSet::get(KeyPath const& key,
+                         T const& default_value,
+                         T convert(Via const&)) const
+{
+  auto result = get_if_present<T>(key, convert);
+  return result ? *result : default_value;
+}
+
+// ----------------------------------------------------------------------
+
 inline bool
 fhicl::ParameterSet::operator==(ParameterSet const& other) const
 {
@@ -363,41 +656,47 @@ template <class T>
 std::optional<T>
 fhicl::ParameterSet::get_one_(std::string const& key) const
 {
-  T value;
+  std::optional<detail::SequenceKey> skey;
   try {
-    auto skey = detail::get_sequence_indices(key);
+    skey.emplace(detail::get_sequence_indices(key));
+  }
+  catch (std::exception const& e) {
+    throw detail::conversion_error(key, typeid(T), e);
+  }
+  return get_one_<T>(*skey, key);
+}
 
+template <class T>
+std::optional<T>
+fhicl::ParameterSet::get_one_(detail::SequenceKey const& skey,
+                              std::string const& key) const
+{
+  T value;
+  try {
     map_iter_t it = mapping_.find(skey.name());
     if (it == mapping_.end()) {
       return std::nullopt;
     }
 
-    auto a = it->second;
-    if (!detail::find_an_any(
-          skey.indices().cbegin(), skey.indices().cend(), a)) {
+    if (skey.indices().empty() && it->second.decode_cached(value)) {
+      return std::make_optional(value);
+    }
+
+    auto const* a = detail::find_an_any(
+      skey.indices().cbegin(), skey.indices().cend(), &it->second.value());
+    if (a == nullptr) {
       throw fhicl::exception(error::cant_find);
     }
 
     using detail::decode;
-    decode(a, value);
+    decode(*a, value);
     return std::make_optional(value);
   }
   catch (fhicl::exception const& e) {
-    std::ostringstream errmsg;
-    errmsg << "\nUnsuccessful attempt to convert FHiCL parameter '" << key
-           << "' to type '" << cet::demangle_symbol(typeid(value).name())
-           << "'.\n\n"
-           << "[Specific error:]";
-    throw fhicl::exception(type_mismatch, errmsg.str(), e);
+    throw detail::conversion_error(key, typeid(value), e);
   }
   catch (std::exception const& e) {
-    std::ostringstream errmsg;
-    errmsg << "\nUnsuccessful attempt to convert FHiCL parameter '" << key
-           << "' to type '" << cet::demangle_symbol(typeid(value).name())
-           << "'.\n\n"
-           << "[Specific error:]\n"
-           << e.what() << "\n\n";
-    throw fhicl::exception(type_mismatch, errmsg.str());
+    throw detail::conversion_error(key, typeid(value), e);
   }
 }
 
@@ -7,7 +7,7 @@
 #include "fhiclcpp/ParameterSetID.h"
 #include "fhiclcpp/ParameterSet.h"
 
-#include <iomanip>
+#include <cstddef>
 
 using namespace boost;
 using namespace cet;
@@ -48,6 +48,10 @@ ParameterSetID::ParameterSetID(std::string const& id)
   }
 }
 
+ParameterSetID::ParameterSetID(sha1::digest_t const& digest) noexcept
+  : valid_{true}, id_{digest}
+{}
+
 // ----------------------------------------------------------------------
 
 bool
@@ -59,14 +63,14 @@ ParameterSetID::is_valid() const noexcept
 string
 ParameterSetID::to_string() const
 {
-  std::ostringstream oss;
-  oss << std::hex << std::setfill('0');
-  // The range-for loop performs an implicit cast from 'unsigned char'
-  // to 'unsigned int'.
-  for (unsigned int const num : id_) {
-    oss << std::setw(2) << num;
+  static constexpr char hex_digits[] = "0123456789abcdef";
+  string result(max_str_size(), '0');
+  std::size_t i{};
+  for (unsigned char const byte : id_) {
+    result[i++] = hex_digits[byte >> 4];
+    result[i++] = hex_digits[byte & 0xf];
   }
-  return oss.str();
+  return result;
 }
 
 // ----------------------------------------------------------------------
@@ -81,10 +85,7 @@ ParameterSetID::invalidate() noexcept
 void
 ParameterSetID::reset(ParameterSet const& ps)
 {
-  auto const hash = ps.to_string();
-  sha1 sha{hash.c_str()};
-
-  id_ = sha.digest();
+  id_ = ps.digest_();
   valid_ = true;
 }
 
@@ -11,6 +11,7 @@
 #include "fhiclcpp/fwd.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <ostream>
 #include <string>
 
@@ -26,10 +27,13 @@ public:
   ParameterSetID() noexcept;
   explicit ParameterSetID(ParameterSet const&);
   explicit ParameterSetID(std::string const& id);
+  explicit ParameterSetID(cet::sha1::digest_t const& digest) noexcept;
 
   // observers:
   bool is_valid() const noexcept;
   std::string to_string() const;
+  cet::sha1::digest_t const& digest() const noexcept;
+  std::size_t hash() const noexcept;
   static constexpr std::size_t max_str_size() noexcept;
 
   // mutators:
@@ -58,6 +62,23 @@ fhicl::ParameterSetID::max_str_size() noexcept
   return 2 * cet::sha1::digest_sz;
 }
 
+inline cet::sha1::digest_t const&
+fhicl::ParameterSetID::digest() const noexcept
+{
+  return id_;
+}
+
+inline std::size_t
+fhicl::ParameterSetID::hash() const noexcept
+{
+  // The digest bytes are already uniformly distributed, so any
+  // sizeof(std::size_t) of them make a perfectly good hash value.
+  static_assert(sizeof(std::size_t) <= cet::sha1::digest_sz);
+  std::size_t result;
+  std::memcpy(&result, id_.data(), sizeof result);
+  return result;
+}
+
 // ======================================================================
 
 #endif /* fhiclcpp_ParameterSetID_h */
@@ -1,31 +1,50 @@
 #include "fhiclcpp/ParameterSetRegistry.h"
 
-#include "cetlib/container_algorithms.h"
 #include "cetlib/sqlite/Transaction.h"
 #include "cetlib/sqlite/column.h"
 #include "cetlib/sqlite/create_table.h"
 #include "cetlib/sqlite/exec.h"
-#include "cetlib/sqlite/query_result.h"
-#include "cetlib/sqlite/select.h"
 #include "fhiclcpp/ParameterSetID.h"
 #include "fhiclcpp/exception.h"
 
 #include "sqlite3.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
 
 #include <cassert>
+#include <cstddef>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 using fhicl::detail::throwOnSQLiteFailure;
 
 std::recursive_mutex fhicl::ParameterSetRegistry::mutex_{};
+std::atomic<bool> fhicl::ParameterSetRegistry::binaryBlobs_{false};
+thread_local fhicl::ParameterSetRegistry::collection_type*
+  fhicl::ParameterSetRegistry::batch_{nullptr};
 
 namespace {
+  constexpr char insert_sql[]{
+    "INSERT OR IGNORE INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);"};
+  constexpr char select_all_sql[]{"SELECT ID, PSetBlob FROM ParameterSets;"};
+  constexpr char select_one_sql[]{
+    "SELECT PSetBlob FROM ParameterSets WHERE ID = ?;"};
+
   sqlite3*
   openPrimaryDB()
   {
     sqlite3* result = nullptr;
     sqlite3_open(":memory:", &result);
     throwOnSQLiteFailure(result);
+    // Nothing is ever synced; a rollback journal is still needed for
+    // transactions.
+    fhicl::detail::sqlite_session{result}.apply(
+      {{"journal_mode", "MEMORY"}, {"synchronous", "OFF"}});
     using namespace cet::sqlite;
     Transaction txn{result};
     create_table(result,
@@ -35,6 +54,149 @@ namespace {
     txn.commit();
     return result;
   }
+
+  struct statement_deleter {
+    void
+    operator()(sqlite3_stmt* stmt) const noexcept
+    {
+      sqlite3_finalize(stmt);
+    }
+  };
+  using statement_ptr = std::unique_ptr<sqlite3_stmt, statement_deleter>;
+
+  statement_ptr
+  prepare(sqlite3* db, char const* sql)
+  {
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    throwOnSQLiteFailure(db);
+    return statement_ptr{stmt};
+  }
+
+  // A PSetBlob is either the text of ParameterSet::to_compact_string()
+  // or, stored as a BLOB, the bytes of
+  // ParameterSet::to_binary_string().
+  std::string_view
+  column_blob(sqlite3_stmt* stmt, int const i)
+  {
+    if (sqlite3_column_type(stmt, i) == SQLITE_BLOB) {
+      return {static_cast<char const*>(sqlite3_column_blob(stmt, i)),
+              static_cast<std::size_t>(sqlite3_column_bytes(stmt, i))};
+    }
+    return reinterpret_cast<char const*>(sqlite3_column_text(stmt, i));
+  }
+
+  fhicl::ParameterSet
+  make_pset(std::string_view const psBlob)
+  {
+    using fhicl::ParameterSet;
+    fhicl::detail::count_parsed_blob(psBlob.size());
+    return ParameterSet::is_binary(psBlob) ?
+             ParameterSet::make_from_binary(psBlob) :
+             ParameterSet::make(std::string{psBlob});
+  }
+
+  // The ID in column i of the current row.  A row without one cannot
+  // be registered.
+  char const*
+  column_id(sqlite3* db, sqlite3_stmt* stmt, int const i)
+  {
+    auto const* id =
+      reinterpret_cast<char const*>(sqlite3_column_text(stmt, i));
+    if (id == nullptr) {
+      throwOnSQLiteFailure(db); // Out of memory, if anything.
+      throw fhicl::exception(fhicl::error::sql_error, "SQLite error:")
+        << "ParameterSets row with a NULL ID.";
+    }
+    return id;
+  }
+
+  // The IDs of the ParameterSets in db, in order.
+  std::vector<std::string>
+  read_ids(sqlite3* db)
+  {
+    statement_ptr const stmt{
+      prepare(db, "SELECT ID FROM ParameterSets ORDER BY ID;")};
+    std::vector<std::string> result;
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+      result.emplace_back(column_id(db, stmt.get(), 0));
+    }
+    if (rc != SQLITE_DONE) {
+      throwOnSQLiteFailure(db);
+    }
+    return result;
+  }
+
+  // A read-only connection to the file of db, holding the given IDs;
+  // or null if there is no such file, if db was not opened through the
+  // default VFS, or if the file cannot be opened or holds other IDs.
+  sqlite3*
+  reopen_readonly(sqlite3* db, std::vector<std::string> const& ids)
+  {
+    char const* filename = sqlite3_db_filename(db, "main");
+    if (filename == nullptr || *filename == '\0') {
+      return nullptr;
+    }
+    sqlite3_vfs* vfs = nullptr;
+    if (sqlite3_file_control(db, "main", SQLITE_FCNTL_VFS_POINTER, &vfs) !=
+          SQLITE_OK ||
+        vfs != sqlite3_vfs_find(nullptr)) {
+      return nullptr;
+    }
+    sqlite3* result = nullptr;
+    if (sqlite3_open_v2(filename, &result, SQLITE_OPEN_READONLY, nullptr) ==
+        SQLITE_OK) {
+      try {
+        if (read_ids(result) == ids) {
+          return result;
+        }
+      }
+      catch (fhicl::exception const&) {
+      }
+    }
+    sqlite3_close(result);
+    return nullptr;
+  }
+
+  // psBlob as exportTo writes it: as text unless binary is requested.
+  // Binary blobs converted to text are held in scratch.
+  std::string_view
+  exported_blob(std::string_view const psBlob,
+                bool const binary,
+                std::string& scratch)
+  {
+    using fhicl::ParameterSet;
+    if (binary || !ParameterSet::is_binary(psBlob)) {
+      return psBlob;
+    }
+    scratch = ParameterSet::make_from_binary(psBlob).to_compact_string();
+    return scratch;
+  }
+
+  // Text is stored including its terminating NUL, as it always has
+  // been; id and a text psBlob must therefore be NUL-terminated.
+  void
+  insert_row(sqlite3* db,
+             sqlite3_stmt* stmt,
+             std::string_view const id,
+             std::string_view const psBlob)
+  {
+    sqlite3_bind_text(stmt, 1, id.data(), id.size() + 1, SQLITE_STATIC);
+    throwOnSQLiteFailure(db);
+    if (fhicl::ParameterSet::is_binary(psBlob)) {
+      sqlite3_bind_blob(stmt, 2, psBlob.data(), psBlob.size(), SQLITE_STATIC);
+    } else {
+      sqlite3_bind_text(
+        stmt, 2, psBlob.data(), psBlob.size() + 1, SQLITE_STATIC);
+    }
+    throwOnSQLiteFailure(db);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+      throwOnSQLiteFailure(db);
+    }
+    sqlite3_reset(stmt);
+    throwOnSQLiteFailure(db);
+  }
 }
 
 void
@@ -62,9 +224,32 @@ fhicl::detail::throwOnSQLiteFailure(sqlite3* db, char* msg)
   throwOnSQLiteFailure(errcode, msg);
 }
 
+// Within the lifetime of an eviction_hold, ParameterSets registered
+// with mutex_ held by its creator are tracked but nothing is evicted:
+// neither lru_ nor the rows of a statement still being stepped may
+// change beneath it.  Holds nest.
+class fhicl::ParameterSetRegistry::eviction_hold {
+public:
+  explicit eviction_hold(ParameterSetRegistry& self) noexcept : self_{self}
+  {
+    ++self_.evictionHolds_;
+  }
+  ~eviction_hold() noexcept { --self_.evictionHolds_; }
+
+  eviction_hold(eviction_hold const&) = delete;
+  eviction_hold& operator=(eviction_hold const&) = delete;
+
+private:
+  ParameterSetRegistry& self_;
+};
+
 fhicl::ParameterSetRegistry::~ParameterSetRegistry()
 {
-  sqlite3_finalize(stmt_);
+  for (auto& source : lazySources_) {
+    source.session.finalize();
+    sqlite3_close(source.db);
+  }
+  primary_.finalize();
   try {
     throwOnSQLiteFailure(primaryDB_);
   }
@@ -83,182 +268,600 @@ void
 fhicl::ParameterSetRegistry::importFrom(sqlite3* db)
 {
   assert(db);
-  std::lock_guard sentry{mutex_};
+  detail::registry_timer timer{detail::registry_op::import};
+  detail::metered_lock sentry{mutex_};
 
   // This does *not* cause anything new to be imported into the
   // registry itself, just its backing DB.
-  sqlite3_stmt* oStmt = nullptr;
-  sqlite3* primaryDB = instance_().primaryDB_;
+  auto& primary = instance_().primary_;
+  sqlite3* primaryDB = primary.db();
 
   // Index constraint on ID will prevent duplicates via INSERT OR IGNORE.
-  sqlite3_prepare_v2(
-    primaryDB,
-    "INSERT OR IGNORE INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);",
-    -1,
-    &oStmt,
-    nullptr);
-  throwOnSQLiteFailure(primaryDB);
-
-  using namespace cet::sqlite;
-  query_result<std::string, std::string> inputPSes;
-  inputPSes << select("*").from(db, "ParameterSets");
-
-  for (auto const& [idString, psBlob] : inputPSes) {
-    sqlite3_bind_text(
-      oStmt, 1, idString.c_str(), idString.size() + 1, SQLITE_STATIC);
-    throwOnSQLiteFailure(primaryDB);
-    sqlite3_bind_text(
-      oStmt, 2, psBlob.c_str(), psBlob.size() + 1, SQLITE_STATIC);
-    throwOnSQLiteFailure(primaryDB);
-    switch (sqlite3_step(oStmt)) {
-    case SQLITE_DONE:
-      break; // OK
-    default:
-      throwOnSQLiteFailure(primaryDB);
-    }
-    sqlite3_reset(oStmt);
-    throwOnSQLiteFailure(primaryDB);
+  auto* const oStmt = primary.statement(insert_sql);
+  statement_ptr const iStmt{prepare(db, select_all_sql)};
+
+  cet::sqlite::Transaction txn{primaryDB};
+  int rc;
+  while ((rc = sqlite3_step(iStmt.get())) == SQLITE_ROW) {
+    insert_row(primaryDB,
+               oStmt,
+               column_id(db, iStmt.get(), 0),
+               column_blob(iStmt.get(), 1));
+  }
+  if (rc != SQLITE_DONE) {
+    throwOnSQLiteFailure(db);
+  }
+  txn.commit();
+}
+
+void
+fhicl::ParameterSetRegistry::importLazilyFrom(sqlite3* db)
+{
+  assert(db);
+  detail::registry_timer timer{detail::registry_op::import};
+  // Only the IDs are read from db.  The blobs are read later through a
+  // second connection, opened now so that a database that cannot be
+  // reopened is imported eagerly instead.
+  auto const ids = read_ids(db);
+  sqlite3* const source = reopen_readonly(db, ids);
+  if (source == nullptr) {
+    importFrom(db);
+    return;
+  }
+
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  auto const index = self.lazySources_.size();
+  self.lazySources_.push_back({source, detail::sqlite_session{source}});
+  // The first source of each ID is the one used, as INSERT OR IGNORE
+  // does for importFrom.
+  for (auto const& id : ids) {
+    self.lazyIndex_.emplace(ParameterSetID{id}, index);
   }
-  sqlite3_finalize(oStmt);
-  throwOnSQLiteFailure(primaryDB);
 }
 
 void
 fhicl::ParameterSetRegistry::exportTo(sqlite3* db)
+{
+  exportTo(db, {});
+}
+
+void
+fhicl::ParameterSetRegistry::exportTo(sqlite3* db,
+                                      detail::sqlite_pragmas const& pragmas)
 {
   assert(db);
-  std::lock_guard sentry{mutex_};
+  detail::registry_timer timer{detail::registry_op::export_to};
+  detail::sqlite_session out{db};
+  out.apply(pragmas);
+
+  bool const binary{binaryBlobs_};
+  std::vector<value_type const*> entries;
+  std::vector<std::string> blobs;
+  detail::metered_lock sentry{mutex_, std::defer_lock};
+  serialize_registered_(sentry, binary, entries, blobs);
+  // Converting a binary blob to text reloads its nested tables, and
+  // nothing may be spilled into the backing DB while it is being read.
+  // Whatever is loaded is evicted by the next registration.
+  eviction_hold const hold{instance_()};
 
+  // Everything is written in a single transaction, so that the output
+  // contains either all of the ParameterSets or none of them.
   cet::sqlite::Transaction txn{db};
   cet::sqlite::exec(db,
                     "DROP TABLE IF EXISTS ParameterSets;"
                     "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);");
-  txn.commit();
+  auto* const oStmt = out.statement(insert_sql);
+  for (std::size_t i = 0, e = entries.size(); i != e; ++i) {
+    insert_row(db, oStmt, entries[i]->first.to_string(), blobs[i]);
+  }
 
-  sqlite3_stmt* oStmt = nullptr;
-  sqlite3_prepare_v2(
-    db,
-    "INSERT OR IGNORE INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);",
-    -1,
-    &oStmt,
-    nullptr);
-  throwOnSQLiteFailure(db);
+  // Then everything only in the backing DB, read in place.  It may be
+  // binary: evicted ParameterSets are spilled as such, and imported
+  // databases may hold either form.
+  std::string scratch;
+  auto& primary = instance_().primary_;
+  sqlite3* const primaryDB{primary.db()};
+  auto* const iStmt = primary.statement(select_all_sql);
+  int rc;
+  while ((rc = sqlite3_step(iStmt)) == SQLITE_ROW) {
+    insert_row(db,
+               oStmt,
+               column_id(primaryDB, iStmt, 0),
+               exported_blob(column_blob(iStmt, 1), binary, scratch));
+  }
+  if (rc != SQLITE_DONE) {
+    throwOnSQLiteFailure(primaryDB);
+  }
 
-  // Calling to_compact_string() can insert entries into the registry
-  // container.  If that insertion causes a rehash, the iterators are
-  // invalidated.  We therefore need to start over in that case and
-  // make sure we can get through the entire list without causing a
-  // rehash.
-  while (std::any_of(get().begin(), get().end(), [oStmt, db](auto const& p) {
-    // The rehash threshold is defined by the STL
-    //    [container.requirements.unord.req.general]
-    auto const current_rehash_threshold =
-      get().max_load_factor() * get().bucket_count();
-    std::string id(p.first.to_string());
-    std::string psBlob(p.second.to_compact_string());
-    if (get().size() > current_rehash_threshold) {
-      return true;
+  // Finally everything lazily imported, straight from its source.
+  for (auto& source : instance_().lazySources_) {
+    auto& session = source.session;
+    auto* const sStmt = session.statement(select_all_sql);
+    while ((rc = sqlite3_step(sStmt)) == SQLITE_ROW) {
+      insert_row(db,
+                 oStmt,
+                 column_id(session.db(), sStmt, 0),
+                 exported_blob(column_blob(sStmt, 1), binary, scratch));
     }
-    sqlite3_bind_text(oStmt, 1, id.c_str(), id.size() + 1, SQLITE_STATIC);
-    throwOnSQLiteFailure(db);
-    sqlite3_bind_text(
-      oStmt, 2, psBlob.c_str(), psBlob.size() + 1, SQLITE_STATIC);
-    throwOnSQLiteFailure(db);
-    switch (sqlite3_step(oStmt)) {
-    case SQLITE_DONE:
-      sqlite3_reset(oStmt);
-      throwOnSQLiteFailure(db);
-      break; // OK
-    default:
-      throwOnSQLiteFailure(db);
+    if (rc != SQLITE_DONE) {
+      throwOnSQLiteFailure(session.db());
     }
-    return false;
-  })) {
   }
 
-  sqlite3* const primaryDB{instance_().primaryDB_};
-  using namespace cet::sqlite;
-  query_result<std::string, std::string> regPSes;
-  regPSes << select("*").from(primaryDB, "ParameterSets");
+  // And everything in mapped snapshots, which is stored in binary.
+  for (auto const& snapshot : instance_().snapshots_) {
+    for (std::size_t i = 0, e = snapshot.size(); i != e; ++i) {
+      auto const id = snapshot.id(i).to_string();
+      insert_row(db,
+                 oStmt,
+                 id,
+                 exported_blob(snapshot.blob(i), binary, scratch));
+    }
+  }
+  txn.commit();
+}
 
-  for (auto const& [idString, psBlob] : regPSes) {
-    sqlite3_bind_text(
-      oStmt, 1, idString.c_str(), idString.size() + 1, SQLITE_STATIC);
-    throwOnSQLiteFailure(db);
-    sqlite3_bind_text(
-      oStmt, 2, psBlob.c_str(), psBlob.size() + 1, SQLITE_STATIC);
-    throwOnSQLiteFailure(db);
-    switch (sqlite3_step(oStmt)) {
-    case SQLITE_DONE:
-      sqlite3_reset(oStmt);
-      throwOnSQLiteFailure(db);
-      break; // OK
-    default:
+void
+fhicl::ParameterSetRegistry::serialize_registered_(
+  detail::metered_lock<std::recursive_mutex>& sentry,
+  bool const binary,
+  std::vector<value_type const*>& entries,
+  std::vector<std::string>& blobs)
+{
+  // Serializing a ParameterSet can register its nested tables (see
+  // ParameterSet::set_shared_nested_tables), so the entries are
+  // collected and serialized in rounds until no new ones appear.
+  // Registered ParameterSets are never modified, and are pinned if
+  // they could be evicted, so they are serialized in parallel without
+  // holding the lock, which is held again on return.
+  std::unordered_set<ParameterSetID, detail::HashParameterSetID> collected;
+  std::vector<ParameterSetID> pinned;
+  auto& self = instance_();
+  sentry.lock();
+  for (;;) {
+    auto const first = entries.size();
+    for (auto const& entry : self.registry_) {
+      if (collected.insert(entry.first).second) {
+        entries.push_back(&entry);
+        if (self.cache_.contains(entry.first)) {
+          ++self.pins_[entry.first];
+          pinned.push_back(entry.first);
+        }
+      }
+    }
+    if (entries.size() == first) {
+      break;
+    }
+    sentry.unlock();
+    blobs.resize(entries.size());
+    tbb::parallel_for(tbb::blocked_range<std::size_t>{first, entries.size()},
+                      [&entries, &blobs, binary](auto const& range) {
+                        for (auto i = range.begin(); i != range.end(); ++i) {
+                          auto const& ps = entries[i]->second;
+                          blobs[i] = binary ? ps.to_binary_string() :
+                                              ps.to_compact_string();
+                        }
+                      });
+    sentry.lock();
+  }
+  // Nothing is evicted before the caller releases the lock.
+  for (auto const& id : pinned) {
+    if (auto const pin = self.pins_.find(id); --pin->second == 0) {
+      self.pins_.erase(pin);
+    }
+  }
+}
+
+void
+fhicl::ParameterSetRegistry::exportSnapshotTo(std::string const& filename)
+{
+  detail::registry_timer timer{detail::registry_op::export_to};
+  std::vector<value_type const*> registered;
+  std::vector<std::string> blobs;
+  detail::metered_lock sentry{mutex_, std::defer_lock};
+  serialize_registered_(sentry, true, registered, blobs);
+
+  std::vector<std::pair<ParameterSetID, std::string>> entries;
+  entries.reserve(registered.size());
+  for (std::size_t i = 0, e = registered.size(); i != e; ++i) {
+    entries.emplace_back(registered[i]->first, std::move(blobs[i]));
+  }
+
+  // Then everything known only to the backing DB, lazily-imported
+  // sources, or mapped snapshots, as stored.  Duplicates are dropped
+  // when the snapshot is written; the registered entries come first
+  // and are kept.
+  auto& self = instance_();
+  auto const append_rows = [&entries](sqlite3* db, sqlite3_stmt* stmt) {
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+      entries.emplace_back(ParameterSetID{column_id(db, stmt, 0)},
+                           column_blob(stmt, 1));
+    }
+    if (rc != SQLITE_DONE) {
       throwOnSQLiteFailure(db);
     }
+  };
+  append_rows(self.primary_.db(), self.primary_.statement(select_all_sql));
+  for (auto& source : self.lazySources_) {
+    auto& session = source.session;
+    append_rows(session.db(), session.statement(select_all_sql));
   }
-  sqlite3_finalize(oStmt);
-  throwOnSQLiteFailure(db);
+  for (auto const& snapshot : self.snapshots_) {
+    for (std::size_t i = 0, e = snapshot.size(); i != e; ++i) {
+      entries.emplace_back(snapshot.id(i), snapshot.blob(i));
+    }
+  }
+  sentry.unlock();
+
+  // Text blobs are converted, so that nothing in the snapshot needs
+  // to be parsed.
+  auto const first = registered.size();
+  tbb::parallel_for(tbb::blocked_range<std::size_t>{first, entries.size()},
+                    [&entries](auto const& range) {
+                      for (auto i = range.begin(); i != range.end(); ++i) {
+                        auto& psBlob = entries[i].second;
+                        if (!ParameterSet::is_binary(psBlob)) {
+                          psBlob = make_pset(psBlob).to_binary_string();
+                        }
+                      }
+                    });
+  detail::registry_snapshot::write(filename, entries);
+}
+
+void
+fhicl::ParameterSetRegistry::importSnapshotFrom(std::string const& filename)
+{
+  detail::registry_timer timer{detail::registry_op::import};
+  detail::registry_snapshot snapshot{filename};
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  self.snapshots_.push_back(std::move(snapshot));
+  self.indexIncomplete_ = true;
+}
+
+void
+fhicl::ParameterSetRegistry::set_binary_blobs(bool const enable) noexcept
+{
+  binaryBlobs_ = enable;
+}
+
+bool
+fhicl::ParameterSetRegistry::binary_blobs() noexcept
+{
+  return binaryBlobs_;
 }
 
 void
 fhicl::ParameterSetRegistry::stageIn()
 {
-  std::lock_guard sentry{mutex_};
-
-  sqlite3* primaryDB = instance_().primaryDB_;
-  auto& registry = instance_().registry_;
-  using namespace cet::sqlite;
-  query_result<std::string, std::string> entriesToStageIn;
-  entriesToStageIn << select("*").from(primaryDB, "ParameterSets");
-
-  cet::transform_all(entriesToStageIn,
-                     std::inserter(registry, std::begin(registry)),
-                     [](auto const& row) {
-                       auto const& [idString, psBlob] = row;
-                       auto const pset = ParameterSet::make(psBlob);
-                       return std::make_pair(ParameterSetID{idString}, pset);
-                     });
+  detail::registry_timer timer{detail::registry_op::stage_in};
+  // The blobs of everything not yet registered are read under the
+  // lock, parsed in parallel without it (parsing is independent for
+  // each blob), and the results inserted under the lock again.
+  std::vector<std::pair<ParameterSetID, std::string>> pending;
+  {
+    detail::metered_lock sentry{mutex_};
+    auto& self = instance_();
+    std::unordered_set<ParameterSetID, detail::HashParameterSetID> seen;
+    auto* const stmt = self.primary_.statement(select_all_sql);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+      ParameterSetID id{column_id(self.primary_.db(), stmt, 0)};
+      if (self.registry_.contains(id) || !seen.insert(id).second) {
+        continue;
+      }
+      pending.emplace_back(std::move(id), column_blob(stmt, 1));
+    }
+    if (rc != SQLITE_DONE) {
+      throwOnSQLiteFailure(self.primary_.db());
+    }
+    std::string psBlob;
+    for (auto const& [id, source] : self.lazyIndex_) {
+      if (self.registry_.contains(id) || seen.contains(id) ||
+          !self.read_lazily_imported_(id, psBlob)) {
+        continue;
+      }
+      pending.emplace_back(id, std::move(psBlob));
+      seen.insert(id);
+    }
+    for (auto const& snapshot : self.snapshots_) {
+      for (std::size_t i = 0, e = snapshot.size(); i != e; ++i) {
+        auto id = snapshot.id(i);
+        if (self.registry_.contains(id) || !seen.insert(id).second) {
+          continue;
+        }
+        pending.emplace_back(std::move(id), snapshot.blob(i));
+      }
+    }
+  }
+
+  std::vector<ParameterSet> psets(pending.size());
+  tbb::parallel_for(tbb::blocked_range<std::size_t>{0, pending.size()},
+                    [&pending, &psets](auto const& range) {
+                      for (auto i = range.begin(); i != range.end(); ++i) {
+                        psets[i] = make_pset(pending[i].second);
+                      }
+                    });
+
+  // Everything is admitted first, then evicted in a single pass.
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  for (std::size_t i = 0, e = pending.size(); i != e; ++i) {
+    auto const it =
+      self.registry_.try_emplace(pending[i].first, std::move(psets[i])).first;
+    self.admit_(it, false);
+  }
+  self.evict_();
 }
 
 fhicl::ParameterSetRegistry::ParameterSetRegistry()
-  : primaryDB_{openPrimaryDB()}
+  : primaryDB_{openPrimaryDB()}, primary_{primaryDB_}
 {}
 
 auto
 fhicl::ParameterSetRegistry::find_(ParameterSetID const& id) -> const_iterator
 {
   // No lock here -- it was already acquired by get(...).
+  detail::registry_timer timer{detail::registry_op::find};
   auto it = registry_.find(id);
-  if (it == registry_.cend()) {
-    // Look in primary DB for this ID and its contained IDs.
-    if (stmt_ == nullptr) {
-      sqlite3_prepare_v2(primaryDB_,
-                         "SELECT PSetBlob FROM ParameterSets WHERE ID = ?;",
-                         -1,
-                         &stmt_,
-                         nullptr);
-      throwOnSQLiteFailure(primaryDB_);
-    }
-    auto idString = id.to_string();
-    auto result = sqlite3_bind_text(
-      stmt_, 1, idString.c_str(), idString.size() + 1, SQLITE_STATIC);
+  if (it != registry_.cend()) {
+    ++stats_.hits;
+    return it;
+  }
+  ++stats_.misses;
+  // Reloading registers the nested tables of a ParameterSet made from
+  // text; none of them may evict anything while the backing DB is
+  // being read, nor before the caller has admitted the result.
+  eviction_hold const hold{*this};
+  if (auto const psBlob = find_in_snapshots_(id); !psBlob.empty()) {
+    detail::count_db_fallback();
+    return registry_.emplace(id, make_pset(psBlob)).first;
+  }
+  // Look in primary DB for this ID and its contained IDs.
+  auto* const stmt = primary_.statement(select_one_sql);
+  auto idString = id.to_string();
+  auto result = sqlite3_bind_text(
+    stmt, 1, idString.c_str(), idString.size() + 1, SQLITE_STATIC);
+  throwOnSQLiteFailure(primaryDB_);
+  result = sqlite3_step(stmt);
+  switch (result) {
+  case SQLITE_ROW: // Found the ID in the DB.
+  {
+    detail::count_db_fallback();
+    auto const pset = make_pset(column_blob(stmt, 0));
+    // Put into the registry without triggering ParameterSet::id().
+    it = registry_.emplace(id, pset).first;
+  } break;
+  case SQLITE_DONE:
+    break; // Not here.
+  default:
     throwOnSQLiteFailure(primaryDB_);
-    result = sqlite3_step(stmt_);
-    switch (result) {
-    case SQLITE_ROW: // Found the ID in the DB.
-    {
-      auto const pset = ParameterSet::make(
-        reinterpret_cast<char const*>(sqlite3_column_text(stmt_, 0)));
-      // Put into the registry without triggering ParameterSet::id().
-      it = registry_.emplace(id, pset).first;
-    } break;
-    case SQLITE_DONE:
-      break; // Not here.
-    default:
-      throwOnSQLiteFailure(primaryDB_);
-    }
-    sqlite3_reset(stmt_);
+  }
+  sqlite3_reset(stmt);
+  if (it != registry_.cend()) {
+    return it;
+  }
+  return find_lazily_imported_(id);
+}
+
+auto
+fhicl::ParameterSetRegistry::find_lazily_imported_(ParameterSetID const& id)
+  -> const_iterator
+{
+  auto it = registry_.find(id);
+  if (it != registry_.cend()) {
+    return it;
+  }
+  if (std::string psBlob; read_lazily_imported_(id, psBlob)) {
+    detail::count_db_fallback();
+    it = registry_.emplace(id, make_pset(psBlob)).first;
   }
   return it;
 }
+
+bool
+fhicl::ParameterSetRegistry::read_lazily_imported_(ParameterSetID const& id,
+                                                   std::string& psBlob)
+{
+  auto const entry = lazyIndex_.find(id);
+  if (entry == lazyIndex_.cend()) {
+    return false;
+  }
+  auto& session = lazySources_[entry->second].session;
+  auto* const db = session.db();
+  auto* const stmt = session.statement(select_one_sql);
+  auto const idString = id.to_string();
+  sqlite3_bind_text(
+    stmt, 1, idString.c_str(), idString.size() + 1, SQLITE_STATIC);
+  throwOnSQLiteFailure(db);
+  bool found{false};
+  switch (sqlite3_step(stmt)) {
+  case SQLITE_ROW:
+    psBlob = column_blob(stmt, 0);
+    found = true;
+    break;
+  case SQLITE_DONE:
+    break; // The file has changed since it was imported.
+  default:
+    throwOnSQLiteFailure(db);
+  }
+  sqlite3_reset(stmt);
+  return found;
+}
+
+void
+fhicl::ParameterSetRegistry::set_memory_budget(std::size_t const bytes)
+{
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  self.budget_ = bytes;
+  if (bytes != 0) {
+    self.indexIncomplete_ = true;
+    self.evict_();
+    return;
+  }
+  // Everything resident is now permanent.
+  for (auto const& [id, entry] : self.cache_) {
+    self.publish_(self.registry_.find(id));
+  }
+  self.cache_.clear();
+  self.lru_.clear();
+  self.stats_.resident_bytes = 0;
+}
+
+std::size_t
+fhicl::ParameterSetRegistry::memory_budget() noexcept
+{
+  return instance_().budget_;
+}
+
+auto
+fhicl::ParameterSetRegistry::pin(ParameterSetID const& id)
+  -> ParameterSet const&
+{
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  auto const it = self.find_(id);
+  if (it == self.registry_.cend()) {
+    throw exception(error::cant_find, "Can't find ParameterSet")
+      << "with ID " << id.to_string() << " in the registry.";
+  }
+  ++self.pins_[id];
+  return self.admit_(it, false).second;
+}
+
+auto
+fhicl::ParameterSetRegistry::get_table_(ParameterSetID const& id)
+  -> detail::table_ref
+{
+  detail::registry_timer timer{detail::registry_op::get};
+  auto& self = instance_();
+  // Published entries are never evicted, nor are those of this
+  // thread's batch before it is committed.
+  if (auto const* ps = self.find_published_(id)) {
+    return detail::table_ref{*ps};
+  }
+  if (auto const* const batch = batch_) {
+    if (auto const it = batch->find(id); it != batch->cend()) {
+      return detail::table_ref{it->second};
+    }
+  }
+
+  detail::metered_lock sentry{mutex_};
+  auto const it = self.find_(id);
+  if (it == self.registry_.cend()) {
+    throw exception(error::cant_find, "Can't find ParameterSet")
+      << "with ID " << id.to_string() << " in the registry.";
+  }
+  auto const& entry = self.admit_(it, false);
+  if (!self.cache_.contains(id)) {
+    return detail::table_ref{entry.second};
+  }
+  ++self.pins_[id];
+  return detail::table_ref{entry.second, id};
+}
+
+void
+fhicl::ParameterSetRegistry::unpin(ParameterSetID const& id)
+{
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  auto const pin = self.pins_.find(id);
+  if (pin == self.pins_.cend()) {
+    return;
+  }
+  if (--pin->second == 0) {
+    self.pins_.erase(pin);
+  }
+}
+
+auto
+fhicl::ParameterSetRegistry::statistics() -> cache_statistics
+{
+  detail::metered_lock sentry{mutex_};
+  return instance_().stats_;
+}
+
+void
+fhicl::ParameterSetRegistry::track_(const_iterator const it,
+                                    bool const mayEvict)
+{
+  // No lock here -- it was already acquired by the caller.
+  ParameterSetID const id{it->first};
+  if (auto const entry = cache_.find(id); entry != cache_.cend()) {
+    lru_.splice(lru_.begin(), lru_, entry->second.lru);
+    return;
+  }
+  if (find_published_(id) != nullptr) {
+    return; // Registered while unbounded.
+  }
+  // Encoding can register nested tables, after which it must not be
+  // used.
+  auto const bytes = it->second.to_binary_string().size();
+  lru_.push_front(id);
+  cache_.emplace(id, cache_entry{lru_.begin(), bytes});
+  stats_.resident_bytes += bytes;
+  evicted_.erase(id);
+  if (mayEvict) {
+    evict_();
+  }
+}
+
+void
+fhicl::ParameterSetRegistry::evict_()
+{
+  // No lock here -- it was already acquired by the caller.  Spilling
+  // can register nested tables, which must not evict anything while
+  // lru_ is being walked.  The most recently used entry is never
+  // evicted, so that its caller may return it.
+  if (evictionHolds_ != 0 || budget_ == 0) {
+    return;
+  }
+  eviction_hold const hold{*this};
+  auto pos = lru_.end();
+  while (stats_.resident_bytes > budget_ && pos != lru_.begin() &&
+         std::prev(pos) != lru_.begin()) {
+    auto const victim = std::prev(pos);
+    if (pins_.contains(*victim)) {
+      pos = victim;
+      continue;
+    }
+    ParameterSetID const id{*victim};
+    spill_(id, registry_.find(id)->second);
+    auto const entry = cache_.find(id);
+    stats_.resident_bytes -= entry->second.bytes;
+    ++stats_.evictions;
+    evicted_.insert(id);
+    cache_.erase(entry);
+    registry_.erase(id);
+    lru_.erase(victim);
+  }
+}
+
+void
+fhicl::ParameterSetRegistry::spill_(ParameterSetID const& id,
+                                    ParameterSet const& ps)
+{
+  // No lock here -- it was already acquired by the caller.
+  if (lazyIndex_.contains(id) || !find_in_snapshots_(id).empty()) {
+    return; // It can be reloaded from there.
+  }
+  // Already there if it was imported, hence OR IGNORE.
+  auto const psBlob = ps.to_binary_string();
+  insert_row(
+    primaryDB_, primary_.statement(insert_sql), id.to_string(), psBlob);
+}
+
+std::string_view
+fhicl::ParameterSetRegistry::find_in_snapshots_(ParameterSetID const& id) const
+{
+  // No lock here -- it was already acquired by the caller.
+  for (auto const& snapshot : snapshots_) {
+    if (auto const psBlob = snapshot.find(id); !psBlob.empty()) {
+      return psBlob;
+    }
+  }
+  return {};
+}
@@ -9,12 +9,24 @@
 
 #include "fhiclcpp/ParameterSet.h"
 #include "fhiclcpp/ParameterSetID.h"
+#include "fhiclcpp/detail/registry_metrics.h"
+#include "fhiclcpp/detail/registry_snapshot.h"
+#include "fhiclcpp/detail/sqlite_session.h"
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/fwd.h"
+#include "tbb/concurrent_unordered_map.h"
 
+#include <atomic>
 #include <concepts>
+#include <cstddef>
+#include <list>
 #include <mutex>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 struct sqlite3;
 struct sqlite3_stmt;
@@ -25,6 +37,7 @@ namespace fhicl {
 
   namespace detail {
     class HashParameterSetID;
+    class registration_batch;
     void throwOnSQLiteFailure(int rc, char* msg = nullptr);
     void throwOnSQLiteFailure(sqlite3* db, char* msg = nullptr);
 
@@ -36,10 +49,7 @@ namespace fhicl {
 
 class fhicl::detail::HashParameterSetID {
 public:
-  size_t operator()(ParameterSetID const& id) const;
-
-private:
-  std::hash<std::string> hash_;
+  size_t operator()(ParameterSetID const& id) const noexcept;
 };
 
 class fhicl::ParameterSetRegistry {
@@ -61,16 +71,85 @@ public:
 
   // DB interaction.
   static void importFrom(sqlite3* db);
+  // Like importFrom, but only the IDs are read.  The blobs are read
+  // when first needed, through a read-only connection to the database
+  // file opened by importLazilyFrom; the file may then be removed or
+  // replaced, but must not be modified in place while this registry is
+  // in use.  A database that cannot be reopened so -- one not backed by
+  // a file, or opened through a VFS other than the default -- is
+  // imported as by importFrom.
+  static void importLazilyFrom(sqlite3* db);
   static void exportTo(sqlite3* db);
+  // The pragmas (e.g. journal_mode, synchronous, cache_size) are
+  // applied to db before anything is written, and remain in effect.
+  static void exportTo(sqlite3* db, detail::sqlite_pragmas const& pragmas);
   static void stageIn();
 
-  // Observers.
+  // Snapshots.  exportSnapshotTo writes every ParameterSet known to the
+  // registry, in binary form, to a single memory-mappable file (see
+  // detail/registry_snapshot.h).  importSnapshotFrom maps such a file
+  // read-only; its ParameterSets are then found by get and has, and
+  // are materialized only when first retrieved.  The file must remain
+  // in place while this registry is in use.
+  static void exportSnapshotTo(std::string const& filename);
+  static void importSnapshotFrom(std::string const& filename);
+
+  // By default, exportTo writes each ParameterSet, however it is held
+  // (in memory, spilled, imported, or mapped), as the text of
+  // ParameterSet::to_compact_string(), which every reader understands.
+  // When enabled, it writes ParameterSet::to_binary_string() instead,
+  // which is read back without parsing.  Both are always read.
+  static void set_binary_blobs(bool enable) noexcept;
+  static bool binary_blobs() noexcept;
+
+  // Memory budget.  By default the registry is unbounded: every
+  // ParameterSet registered stays resident until the end of the job.
+  // With a nonzero budget, in bytes of binary encoding (see
+  // ParameterSet::to_binary_string()), the least recently used
+  // ParameterSets are evicted whenever the budget is exceeded.  Each
+  // is first written to the backing DB unless it can otherwise be
+  // reloaded, and get reloads it when it is next needed.
+  //
+  // ParameterSets registered while the registry is unbounded are
+  // never evicted, nor are pinned ones.  Eviction happens only when a
+  // ParameterSet is registered (by put or stageIn) or the budget is
+  // set; lookups, including reloads, never evict, so the budget may be
+  // exceeded until the next registration.  While a budget is set, a
+  // reference returned by get is therefore invalidated by any later
+  // registration, including one from another thread: pin what must
+  // remain valid.  ParameterSet itself keeps each nested table it reads
+  // pinned for as long as it uses it (see detail/table_ref.h).
+  static void set_memory_budget(std::size_t bytes);
+  static std::size_t memory_budget() noexcept;
+  // Pins are counted; each pin must be matched by an unpin.
+  static ParameterSet const& pin(ParameterSetID const& id);
+  static void unpin(ParameterSetID const& id);
+
+  struct cache_statistics {
+    // Lookups that go through the lock (all of them while a budget is
+    // set), according to whether the ParameterSet was resident.
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t evictions;
+    // Of the ParameterSets that may be evicted.
+    std::size_t resident_bytes;
+  };
+  static cache_statistics statistics();
+
+  // Operation counts and latencies, lock wait and hold times, and
+  // fallbacks to stored blobs; all zero unless built with
+  // FHICLCPP_REGISTRY_METRICS (see detail/registry_metrics.h).
+  static detail::registry_metrics& metrics() noexcept;
+
+  // Observers.  Only resident ParameterSets are counted.
   static bool empty();
   static size_type size();
 
   // Put:
-  // 1. A single ParameterSet.
-  static ParameterSetID const& put(ParameterSet const& ps);
+  // 1. A single ParameterSet.  The ID is returned by value, since the
+  // entry may be evicted (see set_memory_budget).
+  static ParameterSetID put(ParameterSet const& ps);
+  static ParameterSetID put(ParameterSet&& ps);
   // 2. A range of iterator to ParameterSet.
   template <detail::referent_matches<mapped_type> FwdIt>
   static void put(FwdIt begin, FwdIt end);
@@ -81,45 +160,159 @@ public:
   // 4. A collection_type. For each value_type, first == second.id() is
   // a prerequisite.
   static void put(collection_type const& c);
+  // 5. As 4., but the entries are moved (c is left empty) under a
+  // single lock.
+  static void put(collection_type&& c);
 
   // Accessors.
+  // Only resident ParameterSets are included.
   static collection_type const& get() noexcept;
   static ParameterSet const& get(ParameterSetID const& id);
   static bool get(ParameterSetID const& id, ParameterSet& ps);
   static bool has(ParameterSetID const& id);
 
 private:
+  friend class detail::registration_batch;
+  friend detail::table_ref detail::get_table(std::any const&);
+  // As get, but the result is pinned if it could be evicted.
+  static detail::table_ref get_table_(ParameterSetID const& id);
+  class eviction_hold;
   ParameterSetRegistry();
   static ParameterSetRegistry& instance_();
   const_iterator find_(ParameterSetID const& id);
+  const_iterator find_lazily_imported_(ParameterSetID const& id);
+  bool read_lazily_imported_(ParameterSetID const& id, std::string& psBlob);
+  std::string_view find_in_snapshots_(ParameterSetID const& id) const;
+  value_type const& admit_(const_iterator it, bool mayEvict);
+  void track_(const_iterator it, bool mayEvict);
+  void evict_();
+  void spill_(ParameterSetID const& id, ParameterSet const& ps);
+  void publish_(const_iterator it);
+  ParameterSet const* find_published_(ParameterSetID const& id) const;
+  static void serialize_registered_(
+    detail::metered_lock<std::recursive_mutex>& sentry,
+    bool binary,
+    std::vector<value_type const*>& entries,
+    std::vector<std::string>& blobs);
+
+  // Lookups of registered ParameterSets go first to index_, which
+  // holds pointers to the (address-stable) entries of registry_ and
+  // may be read without locking mutex_.  Entries are added to index_
+  // only with mutex_ held, after they have been inserted into
+  // registry_, and are never removed from either; entries that may be
+  // evicted are therefore never added to index_.
+  using index_type = tbb::concurrent_unordered_map<ParameterSetID,
+                                                   ParameterSet const*,
+                                                   detail::HashParameterSetID>;
+
+  // A read-only connection to a database file from which
+  // ParameterSets were lazily imported.
+  struct lazy_source {
+    sqlite3* db{nullptr};
+    detail::sqlite_session session{};
+  };
 
   sqlite3* primaryDB_;
-  sqlite3_stmt* stmt_{nullptr};
+  detail::sqlite_session primary_;
+  std::vector<lazy_source> lazySources_{};
+  // Lazily-imported IDs, with the index of their source.
+  std::unordered_map<ParameterSetID, std::size_t, detail::HashParameterSetID>
+    lazyIndex_{};
+  std::vector<detail::registry_snapshot> snapshots_{};
+
+  // The evictable entries of registry_, most recently used first, with
+  // their sizes; and the IDs of those evicted (and not yet reloaded).
+  struct cache_entry {
+    std::list<ParameterSetID>::iterator lru;
+    std::size_t bytes;
+  };
+  std::atomic<std::size_t> budget_{0};
+  std::list<ParameterSetID> lru_{};
+  std::unordered_map<ParameterSetID, cache_entry, detail::HashParameterSetID>
+    cache_{};
+  std::unordered_map<ParameterSetID, std::size_t, detail::HashParameterSetID>
+    pins_{};
+  std::unordered_set<ParameterSetID, detail::HashParameterSetID> evicted_{};
+  cache_statistics stats_{};
+  // While nonzero, entries are tracked but nothing is evicted (see
+  // eviction_hold).
+  std::size_t evictionHolds_{0};
+
+  // Set (with mutex_ held) once index_ may be missing some known
+  // ParameterSets: those in mapped snapshots, or those subject to
+  // eviction.
+  std::atomic<bool> indexIncomplete_{false};
   collection_type registry_{};
+  index_type index_{};
   static std::recursive_mutex mutex_;
+  static std::atomic<bool> binaryBlobs_;
+  // The ParameterSets put by this thread within its outermost
+  // registration_batch, if any.
+  static thread_local collection_type* batch_;
+};
+
+// Within the lifetime of a registration_batch, the ParameterSets put
+// (by 1.) on the same thread -- e.g. the nested tables of a
+// ParameterSet being built from an intermediate_table -- are collected
+// instead of being registered one at a time; until then, get and has
+// find them only on that thread.  commit() then moves them all into
+// the registry at once, under a single lock.  Batches nest: only the
+// outermost one collects and commits.  Anything not committed is
+// discarded.
+class fhicl::detail::registration_batch {
+public:
+  registration_batch() noexcept;
+  ~registration_batch() noexcept;
+  registration_batch(registration_batch const&) = delete;
+  registration_batch& operator=(registration_batch const&) = delete;
+
+  void commit();
+
+private:
+  ParameterSetRegistry::collection_type pending_{};
+  bool outermost_;
 };
 
 inline bool
 fhicl::ParameterSetRegistry::empty()
 {
-  std::lock_guard sentry{mutex_};
+  detail::metered_lock sentry{mutex_};
   return instance_().registry_.empty();
 }
 
 inline auto
 fhicl::ParameterSetRegistry::size() -> size_type
 {
-  std::lock_guard sentry{mutex_};
+  detail::metered_lock sentry{mutex_};
   return instance_().registry_.size();
 }
 
 // 1.
 inline auto
-fhicl::ParameterSetRegistry::put(ParameterSet const& ps)
-  -> ParameterSetID const&
+fhicl::ParameterSetRegistry::put(ParameterSet const& ps) -> ParameterSetID
 {
-  std::lock_guard sentry{mutex_};
-  return instance_().registry_.emplace(ps.id(), ps).first->first;
+  detail::registry_timer timer{detail::registry_op::put};
+  if (auto* const batch = batch_) {
+    return batch->try_emplace(ps.id(), ps).first->first;
+  }
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  auto const it = self.registry_.emplace(ps.id(), ps).first;
+  return self.admit_(it, true).first;
+}
+
+inline auto
+fhicl::ParameterSetRegistry::put(ParameterSet&& ps) -> ParameterSetID
+{
+  detail::registry_timer timer{detail::registry_op::put};
+  auto const id = ps.id();
+  if (auto* const batch = batch_) {
+    return batch->try_emplace(id, std::move(ps)).first->first;
+  }
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  auto const it = self.registry_.try_emplace(id, std::move(ps)).first;
+  return self.admit_(it, true).first;
 }
 
 // 2.
@@ -140,8 +333,12 @@ template <fhicl::detail::referent_matches<
 inline auto
 fhicl::ParameterSetRegistry::put(FwdIt const b, FwdIt const e) -> void
 {
-  std::lock_guard sentry{mutex_};
-  instance_().registry_.insert(b, e);
+  detail::registry_timer timer{detail::registry_op::put};
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  for (auto it = b; it != e; ++it) {
+    self.admit_(self.registry_.insert(*it).first, true);
+  }
 }
 
 // 4.
@@ -152,10 +349,24 @@ fhicl::ParameterSetRegistry::put(collection_type const& c)
   put(c.cbegin(), c.cend());
 }
 
+// 5.
+inline void
+fhicl::ParameterSetRegistry::put(collection_type&& c)
+{
+  detail::registry_timer timer{detail::registry_op::put};
+  detail::metered_lock sentry{mutex_};
+  auto& self = instance_();
+  // Each node is moved whole; duplicates are left behind, and dropped.
+  while (!c.empty()) {
+    auto const result = self.registry_.insert(c.extract(c.cbegin()));
+    self.admit_(result.position, true);
+  }
+}
+
 inline auto
 fhicl::ParameterSetRegistry::get() noexcept -> collection_type const&
 {
-  std::lock_guard sentry{mutex_};
+  detail::metered_lock sentry{mutex_};
   return instance_().registry_;
 }
 
@@ -163,23 +374,47 @@ inline auto
 fhicl::ParameterSetRegistry::get(ParameterSetID const& id)
   -> ParameterSet const&
 {
-  std::lock_guard sentry{mutex_};
-  auto it = instance_().find_(id);
-  if (it == instance_().registry_.cend()) {
+  detail::registry_timer timer{detail::registry_op::get};
+  auto& self = instance_();
+  if (auto const* ps = self.find_published_(id)) {
+    return *ps;
+  }
+  if (auto const* const batch = batch_) {
+    if (auto const it = batch->find(id); it != batch->cend()) {
+      return it->second;
+    }
+  }
+
+  detail::metered_lock sentry{mutex_};
+  auto it = self.find_(id);
+  if (it == self.registry_.cend()) {
     throw exception(error::cant_find, "Can't find ParameterSet")
       << "with ID " << id.to_string() << " in the registry.";
   }
-  return it->second;
+  return self.admit_(it, false).second;
 }
 
 inline bool
 fhicl::ParameterSetRegistry::get(ParameterSetID const& id, ParameterSet& ps)
 {
-  std::lock_guard sentry{mutex_};
+  detail::registry_timer timer{detail::registry_op::get};
+  auto& self = instance_();
+  if (auto const* found = self.find_published_(id)) {
+    ps = *found;
+    return true;
+  }
+  if (auto const* const batch = batch_) {
+    if (auto const it = batch->find(id); it != batch->cend()) {
+      ps = it->second;
+      return true;
+    }
+  }
+
+  detail::metered_lock sentry{mutex_};
   bool result{false};
-  auto it = instance_().find_(id);
-  if (it != instance_().registry_.cend()) {
-    ps = it->second;
+  auto it = self.find_(id);
+  if (it != self.registry_.cend()) {
+    ps = self.admit_(it, false).second;
     result = true;
   }
   return result;
@@ -188,9 +423,27 @@ fhicl::ParameterSetRegistry::get(ParameterSetID const& id, ParameterSet& ps)
 inline bool
 fhicl::ParameterSetRegistry::has(ParameterSetID const& id)
 {
-  std::lock_guard sentry{mutex_};
-  auto const& reg = instance_().registry_;
-  return reg.find(id) != reg.cend();
+  // Unless there are mapped snapshots or evictable entries, every
+  // entry of the registry is published to the index.
+  auto& self = instance_();
+  if (self.find_published_(id) != nullptr) {
+    return true;
+  }
+  if (auto const* const batch = batch_; batch && batch->contains(id)) {
+    return true;
+  }
+  if (!self.indexIncomplete_) {
+    return false;
+  }
+  detail::metered_lock sentry{mutex_};
+  return self.registry_.contains(id) || self.evicted_.contains(id) ||
+         !self.find_in_snapshots_(id).empty();
+}
+
+inline auto
+fhicl::ParameterSetRegistry::metrics() noexcept -> detail::registry_metrics&
+{
+  return detail::registry_metrics::instance();
 }
 
 inline auto
@@ -200,10 +453,66 @@ fhicl::ParameterSetRegistry::instance_() -> ParameterSetRegistry&
   return s_registry;
 }
 
+inline auto
+fhicl::ParameterSetRegistry::admit_(const_iterator const it,
+                                    bool const mayEvict) -> value_type const&
+{
+  // No lock here -- it was already acquired by the caller.
+  auto const& entry = *it;
+  if (budget_ == 0) {
+    publish_(it);
+  } else {
+    track_(it, mayEvict);
+  }
+  return entry;
+}
+
+inline void
+fhicl::ParameterSetRegistry::publish_(const_iterator const it)
+{
+  // No lock here -- it was already acquired by the caller.
+  index_.emplace(it->first, &it->second);
+}
+
+inline auto
+fhicl::ParameterSetRegistry::find_published_(ParameterSetID const& id) const
+  -> ParameterSet const*
+{
+  auto const it = index_.find(id);
+  return it == index_.cend() ? nullptr : it->second;
+}
+
+inline fhicl::detail::registration_batch::registration_batch() noexcept
+  : outermost_{ParameterSetRegistry::batch_ == nullptr}
+{
+  if (outermost_) {
+    ParameterSetRegistry::batch_ = &pending_;
+  }
+}
+
+inline fhicl::detail::registration_batch::~registration_batch() noexcept
+{
+  if (outermost_) {
+    ParameterSetRegistry::batch_ = nullptr;
+  }
+}
+
+inline void
+fhicl::detail::registration_batch::commit()
+{
+  if (!outermost_) {
+    return;
+  }
+  ParameterSetRegistry::batch_ = nullptr;
+  outermost_ = false;
+  ParameterSetRegistry::put(std::move(pending_));
+}
+
 inline size_t
-fhicl::detail::HashParameterSetID::operator()(ParameterSetID const& id) const
+fhicl::detail::HashParameterSetID::operator()(
+  ParameterSetID const& id) const noexcept
 {
-  return hash_(id.to_string());
+  return id.hash();
 }
 
 #endif /* fhiclcpp_ParameterSetRegistry_h */
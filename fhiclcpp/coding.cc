@@ -11,10 +11,13 @@
 #include "fhiclcpp/ParameterSet.h"
 #include "fhiclcpp/ParameterSetRegistry.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
 #include <limits>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
 
 using namespace fhicl;
 using namespace fhicl::detail;
@@ -54,6 +57,16 @@ literal_infinity()
   return literal_infinity;
 }
 
+// Printable ASCII text without quotes or backslashes: nothing in it
+// needs escaping.
+static bool
+is_plain_text(std::string_view const text)
+{
+  return std::all_of(text.begin(), text.end(), [](char const c) {
+    return c >= ' ' && c <= '~' && c != '"' && c != '\'' && c != '\\';
+  });
+}
+
 static void
 atom_rep(any const& a, std::string& result)
 {
@@ -79,12 +92,34 @@ fhicl::detail::is_nil(std::any const& val)
   return result;
 }
 
+fhicl::detail::table_ref
+fhicl::detail::get_table(any const& val)
+{
+  if (auto const* table = any_cast<shared_table>(&val)) {
+    return table_ref{table->pset()};
+  }
+  return ParameterSetRegistry::get_table_(any_cast<ParameterSetID>(val));
+}
+
 ps_atom_t // string (with quotes)
 fhicl::detail::encode(std::string const& value)
 {
   bool is_quoted = value.size() >= 2 && value[0] == value.end()[-1] &&
                    (value[0] == '\"' || value[0] == '\'');
 
+  // Escaping leaves plain text unchanged: its canonical form is simply
+  // double-quoted.
+  std::string_view text{value};
+  if (is_quoted) {
+    text = text.substr(1, text.size() - 2);
+  }
+  if (is_plain_text(text)) {
+    ps_atom_t result;
+    result.reserve(text.size() + 2);
+    result.append(1, '"').append(text).append(1, '"');
+    return result;
+  }
+
   std::string const& str = is_quoted ? value : '\'' + value + '\'';
 
   extended_value xval;
@@ -115,12 +150,24 @@ fhicl::detail::encode(bool value)
   return value ? literal_true() : literal_false();
 }
 
-ParameterSetID // table
+any // table
 fhicl::detail::encode(ParameterSet const& value)
 {
+  if (ParameterSet::shared_nested_tables()) {
+    return shared_table{value};
+  }
   return ParameterSetRegistry::put(value);
 }
 
+any // table (moved)
+fhicl::detail::encode(ParameterSet&& value)
+{
+  if (ParameterSet::shared_nested_tables()) {
+    return shared_table{std::move(value)};
+  }
+  return ParameterSetRegistry::put(std::move(value));
+}
+
 ps_atom_t // unsigned
 fhicl::detail::encode(std::uintmax_t value)
 {
@@ -204,8 +251,17 @@ fhicl::detail::decode(any const& a, bool& result)
 void // table
 fhicl::detail::decode(any const& a, ParameterSet& result)
 {
-  auto const id = any_cast<ParameterSetID>(a);
-  result = ParameterSetRegistry::get(id);
+  result = *get_table(a);
+}
+
+void // table ID
+fhicl::detail::decode(any const& a, ParameterSetID& result)
+{
+  if (auto const* table = any_cast<shared_table>(&a)) {
+    result = table->registered_id();
+    return;
+  }
+  result = any_cast<ParameterSetID>(a);
 }
 
 void // unsigned
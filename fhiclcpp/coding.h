@@ -23,6 +23,8 @@
 #include "boost/lexical_cast.hpp"
 #include "boost/numeric/conversion/cast.hpp"
 #include "fhiclcpp/ParameterSetID.h"
+#include "fhiclcpp/detail/shared_table.h"
+#include "fhiclcpp/detail/table_ref.h"
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/extended_value.h"
 #include "fhiclcpp/fwd.h"
@@ -55,9 +57,14 @@ namespace fhicl::detail {
   inline bool
   is_table(std::any const& val)
   {
-    return val.type() == typeid(ParameterSetID);
+    return val.type() == typeid(ParameterSetID) ||
+           val.type() == typeid(shared_table);
   }
 
+  // The nested table held by val, whichever way it is held, kept in
+  // memory while the result exists.
+  table_ref get_table(std::any const& val);
+
   bool is_nil(std::any const& val);
 
   // ----------------------------------------------------------------------
@@ -66,7 +73,8 @@ namespace fhicl::detail {
   ps_atom_t encode(char const*);              // string (w/ quotes)
   ps_atom_t encode(std::nullptr_t);           // nil
   ps_atom_t encode(bool);                     // bool
-  ParameterSetID encode(ParameterSet const&); // table
+  std::any encode(ParameterSet const&); // table
+  std::any encode(ParameterSet&&);      // table (moved)
   ps_atom_t encode(std::uintmax_t);           // unsigned
   template <std::unsigned_integral T>
   ps_atom_t encode(T const&);      // unsigned
@@ -80,6 +88,8 @@ namespace fhicl::detail {
   ps_atom_t encode(std::complex<T> const&); // complex
   template <class T>
   ps_sequence_t encode(std::vector<T> const&); // sequence
+  template <class T>
+  ps_sequence_t encode(std::vector<T>&&); // sequence (moved elements)
   template <non_numeric T>
   std::string encode(T const&); // none of the above
 
@@ -89,6 +99,7 @@ namespace fhicl::detail {
   void decode(std::any const&, std::nullptr_t&); // nil
   void decode(std::any const&, bool&);           // bool
   void decode(std::any const&, ParameterSet&);   // table
+  void decode(std::any const&, ParameterSetID&); // table ID
   void decode(std::any const&, std::uintmax_t&); // unsigned
 
   template <std::unsigned_integral T>
@@ -190,12 +201,29 @@ fhicl::detail::ps_sequence_t
 fhicl::detail::encode(std::vector<T> const& value)
 {
   ps_sequence_t result;
+  result.reserve(value.size());
   for (auto const& e : value) {
     result.emplace_back(encode(e));
   }
   return result;
 }
 
+template <class T> // sequence (moved elements)
+fhicl::detail::ps_sequence_t
+fhicl::detail::encode(std::vector<T>&& value)
+{
+  if constexpr (std::same_as<T, bool>) {
+    return encode(std::as_const(value));
+  } else {
+    ps_sequence_t result;
+    result.reserve(value.size());
+    for (auto& e : value) {
+      result.emplace_back(encode(std::move(e)));
+    }
+    return result;
+  }
+}
+
 template <fhicl::detail::non_numeric T> // none of the above
 std::string
 fhicl::detail::encode(T const& value)
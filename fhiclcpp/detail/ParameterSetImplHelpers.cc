@@ -1,15 +1,43 @@
 #include "fhiclcpp/detail/ParameterSetImplHelpers.h"
 #include "boost/algorithm/string.hpp"
-#include "cetlib/container_algorithms.h"
-#include "cetlib/split_by_regex.h"
+#include "cetlib_except/demangle.h"
 #include "fhiclcpp/coding.h"
 #include "fhiclcpp/exception.h"
 
 #include <algorithm>
-#include <regex>
+#include <limits>
+#include <sstream>
+#include <utility>
 
 namespace {
-  std::regex const reBrackets{R"((\]\[|\[|\]))"};
+  // Conversion of one index token, with the same results (including
+  // any exception thrown) as std::stoul.  Plain digit strings that
+  // cannot overflow are converted directly.
+  std::size_t
+  to_index(std::string const& key,
+           std::string::size_type const b,
+           std::string::size_type const e)
+  {
+    constexpr auto max_safe_digits =
+      static_cast<std::string::size_type>(
+        std::numeric_limits<std::size_t>::digits10);
+    auto const sz = e - b;
+    if (sz != 0 && sz <= max_safe_digits) {
+      std::size_t result{};
+      auto i = b;
+      for (; i != e; ++i) {
+        auto const c = key[i];
+        if (c < '0' || c > '9') {
+          break;
+        }
+        result = result * 10 + static_cast<std::size_t>(c - '0');
+      }
+      if (i == e) {
+        return result;
+      }
+    }
+    return std::stoul(key.substr(b, sz));
+  }
 }
 
 namespace fhicl::detail {
@@ -55,9 +83,8 @@ namespace fhicl::detail {
   //===============================================================
   // get_sequence_indices
 
-  SequenceKey::SequenceKey(std::string const& name,
-                           std::vector<std::size_t> const& indices)
-    : name_{name}, indices_{indices}
+  SequenceKey::SequenceKey(std::string name, std::vector<std::size_t> indices)
+    : name_{std::move(name)}, indices_{std::move(indices)}
   {}
 
   SequenceKey::~SequenceKey() = default;
@@ -77,39 +104,87 @@ namespace fhicl::detail {
   SequenceKey
   get_sequence_indices(std::string const& key)
   {
-    // Split "name[0][5][1]" according to delimiters "][", "[", and "]"
-    // to give {"name","0","5","1"};
-    auto tokens = cet::split_by_regex(key, reBrackets);
+    constexpr auto npos = std::string::npos;
 
-    auto const name = tokens.front();
-    tokens.erase(tokens.begin());
+    // Keys without brackets name a parameter directly.
+    auto const name_end = key.find_first_of("[]");
+    if (name_end == npos) {
+      return SequenceKey{key, {}};
+    }
 
+    // Split "name[0][5][1]" according to delimiters "][", "[", and "]"
+    // to give {"name","0","5","1"}.  As for a regex-based split, empty
+    // tokens between delimiters are kept, but an empty trailing token
+    // is not.
     std::vector<std::size_t> indices;
-    cet::transform_all(
-      tokens, std::back_inserter(indices), [](std::string const& index) {
-        return std::stoul(index);
-      });
-    return SequenceKey{name, indices};
+    auto const sz = key.size();
+    auto pos = name_end;
+    while (pos != npos) {
+      pos += (key[pos] == ']' && pos + 1 != sz && key[pos + 1] == '[') ? 2 : 1;
+      auto const next = key.find_first_of("[]", pos);
+      if (next != npos || pos != sz) {
+        indices.push_back(to_index(key, pos, next == npos ? sz : next));
+      }
+      pos = next;
+    }
+    return SequenceKey{key.substr(0, name_end), std::move(indices)};
   }
 
-  bool
+  std::any const*
   find_an_any(std::vector<std::size_t>::const_iterator it,
               std::vector<std::size_t>::const_iterator const cend,
-              std::any& a)
+              std::any const* a)
   {
     if (it == cend) {
       // If we got this far, that means the element must exist,
-      // otherwise the previous recursive 'find_parameter' call would
-      // have returned false.
-      return true;
+      // otherwise the previous recursive 'find_an_any' call would
+      // have returned nullptr.
+      return a;
     }
 
-    auto seq = std::any_cast<ps_sequence_t>(a);
-    if (*it >= seq.size())
-      return false;
+    auto const* seq = std::any_cast<ps_sequence_t>(a);
+    if (seq == nullptr) {
+      throw std::bad_any_cast{};
+    }
+    if (*it >= seq->size())
+      return nullptr;
 
-    a = std::move(seq[*it]);
+    auto const* next = &(*seq)[*it];
+    return find_an_any(++it, cend, next);
+  }
 
-    return find_an_any(++it, cend, a);
+  //===============================================================
+  // conversion_error
+
+  namespace {
+    std::string
+    conversion_preamble(std::string const& key, std::type_info const& type)
+    {
+      std::ostringstream errmsg;
+      errmsg << "\nUnsuccessful attempt to convert FHiCL parameter '" << key
+             << "' to type '" << cet::demangle_symbol(type.name())
+             << "'.\n\n"
+             << "[Specific error:]";
+      return errmsg.str();
+    }
+  }
+
+  fhicl::exception
+  conversion_error(std::string const& key,
+                   std::type_info const& type,
+                   fhicl::exception const& e)
+  {
+    return fhicl::exception(
+      type_mismatch, conversion_preamble(key, type), e);
+  }
+
+  fhicl::exception
+  conversion_error(std::string const& key,
+                   std::type_info const& type,
+                   std::exception const& e)
+  {
+    return fhicl::exception(type_mismatch,
+                            conversion_preamble(key, type) + "\n" +
+                              e.what() + "\n\n");
   }
 }
@@ -1,8 +1,12 @@
 #ifndef fhiclcpp_detail_ParameterSetImplHelpers_h
 #define fhiclcpp_detail_ParameterSetImplHelpers_h
 
+#include "fhiclcpp/exception.h"
+
 #include <any>
+#include <exception>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 namespace fhicl::detail {
@@ -30,8 +34,11 @@ namespace fhicl::detail {
 
   class SequenceKey {
   public:
-    SequenceKey(std::string const& name,
-                std::vector<std::size_t> const& indices);
+    SequenceKey(std::string name, std::vector<std::size_t> indices);
+    SequenceKey(SequenceKey const&) = default;
+    SequenceKey(SequenceKey&&) = default;
+    SequenceKey& operator=(SequenceKey const&) = default;
+    SequenceKey& operator=(SequenceKey&&) = default;
     ~SequenceKey();
 
     std::string const& name() const noexcept;
@@ -47,9 +54,26 @@ namespace fhicl::detail {
   //===============================================================
   // find_an_any
 
-  bool find_an_any(std::vector<std::size_t>::const_iterator it,
-                   std::vector<std::size_t>::const_iterator const cend,
-                   std::any& a);
+  // Returns a pointer to the (possibly nested) sequence element
+  // addressed by the indices [it, cend), or nullptr if an index is out
+  // of range.  No copies of intermediate sequences are made.
+  std::any const* find_an_any(
+    std::vector<std::size_t>::const_iterator it,
+    std::vector<std::size_t>::const_iterator const cend,
+    std::any const* a);
+
+  //===============================================================
+  // conversion_error
+  //
+  // Exception reported when the value of the parameter 'key' cannot be
+  // retrieved as an object of the given type.
+
+  fhicl::exception conversion_error(std::string const& key,
+                                    std::type_info const& type,
+                                    fhicl::exception const& e);
+  fhicl::exception conversion_error(std::string const& key,
+                                    std::type_info const& type,
+                                    std::exception const& e);
 }
 
 #endif /* fhiclcpp_detail_ParameterSetImplHelpers_h */
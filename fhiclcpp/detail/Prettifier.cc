@@ -24,13 +24,13 @@ Prettifier::Prettifier(unsigned const initial_indent_level)
 
 //==========================================================================
 void
-Prettifier::before_action(key_t const& key,
+Prettifier::before_action(key_t const&,
                           any_t const& a,
-                          ParameterSet const* ps)
+                          ParameterSet const*)
 {
   if (!is_table(a))
     return;
-  table_size_ = ps->get<fhicl::ParameterSet>(key).get_all_keys().size();
+  table_size_ = get_table(a)->get_all_keys().size();
 }
 
 //==========================================================================
@@ -28,14 +28,14 @@ ValuePrinter::ValuePrinter(std::string const& key_to_search,
 void
 ValuePrinter::before_action(key_t const& key,
                             any_t const& a,
-                            ParameterSet const* ps)
+                            ParameterSet const*)
 {
   if (key_ == key) {
     print_encapsulated_values_ = true;
   }
   if (!is_table(a))
     return;
-  table_size_ = ps->get<fhicl::ParameterSet>(key).get_all_keys().size();
+  table_size_ = get_table(a)->get_all_keys().size();
 }
 
 void
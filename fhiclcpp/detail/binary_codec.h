@@ -0,0 +1,136 @@
+#ifndef fhiclcpp_detail_binary_codec_h
+#define fhiclcpp_detail_binary_codec_h
+
+// ======================================================================
+//
+// binary_codec: the primitives of the binary forms of a ParameterSet
+//               (see ParameterSet::to_binary_string) and of a cached
+//               intermediate_table (see parse_cache):
+//
+//   string  := count byte*
+//   count   := unsigned LEB128
+//
+// A binary_decoder reads them in place from bytes held elsewhere; on
+// malformed input it throws a parse_error naming the form being read
+// and the offending byte.
+//
+// ======================================================================
+
+#include "fhiclcpp/exception.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace fhicl::detail {
+
+  inline void
+  write_count(std::string& out, std::size_t n)
+  {
+    while (n >= 0x80) {
+      out.push_back(static_cast<char>((n & 0x7f) | 0x80));
+      n >>= 7;
+    }
+    out.push_back(static_cast<char>(n));
+  }
+
+  inline void
+  write_bytes(std::string& out, std::string_view const bytes)
+  {
+    write_count(out, bytes.size());
+    out.append(bytes);
+  }
+
+  class binary_decoder {
+  public:
+    // form, e.g. "binary ParameterSet: ", prefixes every error.
+    binary_decoder(std::string_view const bytes,
+                   char const* const form) noexcept
+      : bytes_{bytes}, form_{form}
+    {}
+
+    unsigned char
+    byte()
+    {
+      if (pos_ == bytes_.size()) {
+        fail("unexpected end");
+      }
+      return static_cast<unsigned char>(bytes_[pos_++]);
+    }
+
+    std::size_t
+    count()
+    {
+      std::size_t result{};
+      for (unsigned shift{};; shift += 7) {
+        if (shift >= 8 * sizeof result) {
+          fail("count too large");
+        }
+        auto const b = byte();
+        result |= std::size_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+          return result;
+        }
+      }
+    }
+
+    std::string_view
+    bytes(std::size_t const n)
+    {
+      if (n > remaining()) {
+        fail("unexpected end");
+      }
+      auto const result = bytes_.substr(pos_, n);
+      pos_ += n;
+      return result;
+    }
+
+    std::string
+    string()
+    {
+      return std::string{bytes(count())};
+    }
+
+    // The bytes not yet read: also a bound on the number of elements
+    // still to come, for reserving space without trusting a count.
+    std::size_t
+    remaining() const noexcept
+    {
+      return bytes_.size() - pos_;
+    }
+
+    // Steps back over the byte just read, so that fail reports it.
+    void
+    unread() noexcept
+    {
+      --pos_;
+    }
+
+    void
+    expect_end() const
+    {
+      if (pos_ != bytes_.size()) {
+        fail("trailing bytes");
+      }
+    }
+
+    [[noreturn]] void
+    fail(char const* const what) const
+    {
+      throw exception(error::parse_error, form_)
+        << what << " at byte " << pos_ << ".\n";
+    }
+
+  private:
+    std::string_view bytes_;
+    char const* form_;
+    std::size_t pos_{};
+  };
+
+}
+
+#endif /* fhiclcpp_detail_binary_codec_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -5,11 +5,12 @@
 // ======================================================================
 
 #include "fhiclcpp/ParameterSet.h"
-#include "fhiclcpp/ParameterSetRegistry.h"
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/extended_value.h"
 #include "fhiclcpp/intermediate_table.h"
 
+#include <utility>
+
 using namespace fhicl;
 
 using atom_t = intermediate_table::atom_t;
@@ -49,7 +50,7 @@ fhicl::detail::encode(extended_value const& xval)
       if (!value.in_prolog)
         result.put(key, value);
     }
-    return ParameterSetRegistry::put(result);
+    return encode(std::move(result));
   }
 
   case TABLEID: {
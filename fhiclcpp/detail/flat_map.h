@@ -0,0 +1,208 @@
+#ifndef fhiclcpp_detail_flat_map_h
+#define fhiclcpp_detail_flat_map_h
+
+// ======================================================================
+//
+// flat_map: an ordered associative container backed by a sorted
+//           contiguous vector of key-value pairs.
+//
+// Only the subset of the std::map interface used by ParameterSet is
+// provided.  Iteration is in key order, exactly as for std::map, so
+// that the canonical string (and hence the ParameterSetID) of a
+// ParameterSet does not depend on the choice of backing store.
+//
+// Lookup is a binary search over contiguous storage; insertion is
+// linear in the number of subsequent elements, except for keys that
+// sort after every existing key, which are appended in constant
+// (amortized) time.  Any insertion or erasure invalidates iterators
+// and references to elements.
+//
+// ======================================================================
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace fhicl::detail {
+
+  template <class Key, class T, class Compare = std::less<>>
+  class flat_map {
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using key_compare = Compare;
+    using container_type = std::vector<value_type>;
+    using size_type = typename container_type::size_type;
+    using iterator = typename container_type::iterator;
+    using const_iterator = typename container_type::const_iterator;
+
+    // Iterators
+    iterator
+    begin() noexcept
+    {
+      return elements_.begin();
+    }
+    iterator
+    end() noexcept
+    {
+      return elements_.end();
+    }
+    const_iterator
+    begin() const noexcept
+    {
+      return elements_.begin();
+    }
+    const_iterator
+    end() const noexcept
+    {
+      return elements_.end();
+    }
+    const_iterator
+    cbegin() const noexcept
+    {
+      return elements_.cbegin();
+    }
+    const_iterator
+    cend() const noexcept
+    {
+      return elements_.cend();
+    }
+
+    // Capacity
+    bool
+    empty() const noexcept
+    {
+      return elements_.empty();
+    }
+    size_type
+    size() const noexcept
+    {
+      return elements_.size();
+    }
+    void
+    reserve(size_type const n)
+    {
+      elements_.reserve(n);
+    }
+
+    // Lookup
+    template <class K>
+    iterator
+    find(K const& key)
+    {
+      auto it = lower_bound_(elements_, key);
+      return matches_(it, key) ? it : end();
+    }
+
+    template <class K>
+    const_iterator
+    find(K const& key) const
+    {
+      auto it = lower_bound_(elements_, key);
+      return matches_(it, key) ? it : end();
+    }
+
+    template <class K>
+    size_type
+    count(K const& key) const
+    {
+      return find(key) != end();
+    }
+
+    // Modifiers
+    template <class K, class... Args>
+    std::pair<iterator, bool>
+    emplace(K&& key, Args&&... args)
+    {
+      // Fast path: keys presented in order are simply appended.
+      if (elements_.empty() || comp_(elements_.back().first, key)) {
+        elements_.emplace_back(std::piecewise_construct,
+                               std::forward_as_tuple(std::forward<K>(key)),
+                               std::forward_as_tuple(
+                                 std::forward<Args>(args)...));
+        return {std::prev(end()), true};
+      }
+      auto it = lower_bound_(elements_, key);
+      if (matches_(it, key)) {
+        return {it, false};
+      }
+      it = elements_.emplace(
+        it,
+        std::piecewise_construct,
+        std::forward_as_tuple(std::forward<K>(key)),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+      return {it, true};
+    }
+
+    // As for std::map, the mapped value is constructed from args; this
+    // is what emplace does here already.
+    template <class K, class... Args>
+    std::pair<iterator, bool>
+    try_emplace(K&& key, Args&&... args)
+    {
+      return emplace(std::forward<K>(key), std::forward<Args>(args)...);
+    }
+
+    template <class K>
+    T&
+    operator[](K&& key)
+    {
+      return emplace(std::forward<K>(key)).first->second;
+    }
+
+    template <class K>
+    size_type
+    erase(K const& key)
+    {
+      auto it = find(key);
+      if (it == end()) {
+        return 0u;
+      }
+      elements_.erase(it);
+      return 1u;
+    }
+
+    void
+    clear() noexcept
+    {
+      elements_.clear();
+    }
+
+  private:
+    // Works for both const and non-const access to elements_.
+    template <class Elements, class K>
+    auto
+    lower_bound_(Elements& elements, K const& key) const
+    {
+      return std::lower_bound(
+        elements.begin(),
+        elements.end(),
+        key,
+        [this](value_type const& element, K const& k) {
+          return comp_(element.first, k);
+        });
+    }
+
+    template <class It, class K>
+    bool
+    matches_(It const it, K const& key) const
+    {
+      return it != elements_.end() && !comp_(key, it->first);
+    }
+
+    container_type elements_;
+    [[no_unique_address]] Compare comp_{};
+  };
+
+}
+
+#endif /* fhiclcpp_detail_flat_map_h */
+
+// Local Variables:
+// mode: c++
+// End:
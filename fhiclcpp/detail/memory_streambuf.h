@@ -0,0 +1,63 @@
+#ifndef fhiclcpp_detail_memory_streambuf_h
+#define fhiclcpp_detail_memory_streambuf_h
+
+// ======================================================================
+//
+// memory_streambuf: a read-only stream buffer over characters owned
+//                   elsewhere.
+//
+// Unlike std::istringstream, which copies the string it is given, the
+// characters are read in place; they must outlive the buffer.
+// Positioning (tellg, seekg) is supported within the characters.
+//
+// ======================================================================
+
+#include <ios>
+#include <streambuf>
+#include <string_view>
+
+namespace fhicl::detail {
+
+  class memory_streambuf : public std::streambuf {
+  public:
+    explicit memory_streambuf(std::string_view const text)
+    {
+      // The get area is never written through.
+      auto* const first = const_cast<char*>(text.data());
+      setg(first, first, first + text.size());
+    }
+
+  protected:
+    pos_type
+    seekoff(off_type const off,
+            std::ios_base::seekdir const dir,
+            std::ios_base::openmode const which) override
+    {
+      if (!(which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+      }
+      off_type const base = dir == std::ios_base::beg ? 0 :
+                            dir == std::ios_base::cur ? gptr() - eback() :
+                                                        egptr() - eback();
+      off_type const pos = base + off;
+      if (pos < 0 || pos > egptr() - eback()) {
+        return pos_type(off_type(-1));
+      }
+      setg(eback(), eback() + pos, egptr());
+      return pos_type(pos);
+    }
+
+    pos_type
+    seekpos(pos_type const pos, std::ios_base::openmode const which) override
+    {
+      return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+  };
+
+}
+
+#endif /* fhiclcpp_detail_memory_streambuf_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,347 @@
+// ======================================================================
+//
+// parse_actions
+//
+// ======================================================================
+
+#include "fhiclcpp/detail/parse_actions.h"
+
+#include "cetlib/canonical_number.h"
+#include "cetlib/canonical_string.h"
+#include "fhiclcpp/exception.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace fhicl;
+using fhicl::detail::binding_modifier;
+using fhicl::detail::document_actions;
+using sequence_t = extended_value::sequence_t;
+using table_t = extended_value::table_t;
+
+// ----------------------------------------------------------------------
+
+namespace {
+
+  void
+  check_element_protections(std::string const& name,
+                            Protection const p,
+                            extended_value& v)
+  {
+    using std::max;
+    if (v.protection == Protection::NONE) {
+      v.protection = p;
+    } else if (v.protection < p) {
+      throw fhicl::exception(fhicl::error::protection_violation)
+        << "Nested item " << name << " has protection "
+        << to_string(v.protection)
+        << ((!v.src_info.empty()) ?
+              (std::string(" on ") + v.pretty_src_info()) :
+              "")
+        << ", which is incompatible with an enclosing item's protection of "
+        << to_string(p) << "\n";
+    }
+
+    if (v.tag == fhicl::SEQUENCE) {
+      std::size_t count = 0;
+      for (auto& subv : sequence_t(v)) {
+        check_element_protections(
+          name + '[' + std::to_string(count) + ']', max(p, v.protection), subv);
+      }
+    } else if (v.tag == fhicl::TABLE) {
+      for (auto& [key, value] : table_t(v)) {
+        std::string sname(name);
+        if (!sname.empty()) {
+          sname.append(".");
+        }
+        sname.append(key);
+        check_element_protections(sname, max(p, v.protection), value);
+      }
+    }
+  }
+
+  void
+  check_protection(std::string const& name, extended_value& v)
+  {
+    if (v.is_a(SEQUENCE) || v.is_a(TABLE)) {
+      check_element_protections(name, v.protection, v);
+    }
+  }
+
+}
+
+// ----------------------------------------------------------------------
+
+std::string
+fhicl::detail::canon_nil()
+{
+  static std::string const canon_nil(9, '\0');
+  return canon_nil;
+}
+
+std::string
+fhicl::detail::canon_inf(std::string const& inf)
+{
+  return inf[0] == 'i' ? ('+' + inf) : inf;
+}
+
+std::string
+fhicl::detail::canon_num(std::string const& num)
+{
+  std::string result;
+  return cet::canonical_number(num, result) ?
+           result :
+           throw fhicl::exception(fhicl::error::parse_error)
+             << "The string '" << num
+             << "' is not representable as a canonical number.";
+}
+
+std::string
+fhicl::detail::canon_str(std::string const& str)
+{
+  std::string result;
+  return cet::canonical_string(str, result) ?
+           result :
+           throw fhicl::exception(fhicl::error::parse_error)
+             << "The string " + str +
+                  " is not representable as a canonical string.\n"
+             << "It is likely you have an unescaped (or incorrectly escaped) "
+                "character.";
+}
+
+void
+fhicl::detail::set_protection(std::string const& name,
+                              binding_modifier const m,
+                              extended_value& v)
+{
+  if (m == binding_modifier::NONE) {
+    return;
+  }
+
+  v.protection = static_cast<Protection>(m);
+  check_protection(name, v);
+}
+
+void
+fhicl::detail::map_insert(std::string const& name,
+                          binding_modifier const m,
+                          extended_value& value,
+                          table_t& t)
+{
+  set_protection(name, m, value);
+  auto const i = t.find(name);
+  if (i != t.end()) {
+    auto existing_protection = i->second.protection;
+    if (value.protection > existing_protection) {
+      throw fhicl::exception(fhicl::error::protection_violation)
+        << "Inserting name " << name << " would increase protection from "
+        << to_string(existing_protection) << " to "
+        << to_string(value.protection) << "\n(previous definition on "
+        << i->second.pretty_src_info() << ")\n";
+    }
+    switch (i->second.protection) {
+    case Protection::NONE:
+      break;
+    case Protection::PROTECT_IGNORE:
+      // Do not overwrite protected binding.
+      return;
+    case Protection::PROTECT_ERROR:
+      throw fhicl::exception(fhicl::error::protection_violation)
+        << '"' << name << "\" is protected on " << i->second.pretty_src_info()
+        << '\n';
+    }
+  }
+  // The value is consumed by its binding.
+  t[name] = std::move(value);
+}
+
+void
+fhicl::detail::map_erase(std::string const& name, table_t& t)
+{
+  auto const i = t.find(name);
+  if (i == t.end())
+    return;
+
+  switch (i->second.protection) {
+  case Protection::NONE:
+    t.erase(name);
+  case Protection::PROTECT_IGNORE:
+    return;
+  case Protection::PROTECT_ERROR:
+    throw fhicl::exception(fhicl::error::protection_violation)
+      << "Unable to erase " << name << " due to protection.\n";
+  }
+}
+
+void
+fhicl::detail::seq_insert_value(extended_value xval, sequence_t& v)
+{
+  xval.protection = Protection::NONE;
+  v.emplace_back(std::move(xval));
+}
+
+// ----------------------------------------------------------------------
+
+extended_value
+document_actions::local_lookup(std::string const& name, iter_t const pos)
+try {
+  extended_value result = tbl.find(name);
+  result.set_prolog(in_prolog);
+  result.set_src_info(sref.src_whereis(pos));
+  result.reset_protection();
+  return result;
+}
+catch (fhicl::exception const& e) {
+  throw fhicl::exception(fhicl::error::parse_error, "Local lookup error", e)
+    << "at " << sref.highlighted_whereis(pos) << "\n";
+}
+
+extended_value
+document_actions::database_lookup(iter_t const pos)
+{
+  throw fhicl::exception(fhicl::error::unimplemented, "Database lookup error")
+    << "at " << sref.highlighted_whereis(pos)
+    << "\nFHiCL-cpp database lookup not yet available.\n";
+}
+
+void
+document_actions::insert_table_in_table(std::string const& name,
+                                        table_t& t,
+                                        iter_t const pos)
+{
+  extended_value const xval = local_lookup(name, pos);
+  if (!xval.is_a(fhicl::TABLE)) {
+    throw fhicl::exception(fhicl::error::type_mismatch, "@table::")
+      << "key \"" << name << "\" does not refer to a table at "
+      << sref.highlighted_whereis(pos) << "\n";
+  }
+  auto const& incoming = std::any_cast<table_t const&>(xval.value);
+  for (auto const& [name, value] : incoming) {
+    auto& element = t[name];
+    if (!element.is_a(fhicl::UNKNOWN)) {
+      // Already exists.
+      auto const incoming_protection = value.protection;
+      if (incoming_protection > element.protection) {
+        throw fhicl::exception(fhicl::error::protection_violation)
+          << "@table::" << name << ": inserting name " << name
+          << " would increase protection from "
+          << to_string(element.protection) << " to "
+          << to_string(incoming_protection) << "\n(previous definition on "
+          << element.pretty_src_info() << ")\n";
+      }
+      switch (element.protection) {
+      case Protection::NONE:
+        break;
+      case Protection::PROTECT_IGNORE:
+        continue;
+      case Protection::PROTECT_ERROR:
+        throw fhicl::exception(fhicl::error::protection_violation)
+          << "@table::" << name << ": inserting name " << name
+          << "would violate protection on existing item"
+          << "\n(previous definition on " << element.pretty_src_info()
+          << ")\n";
+      }
+    }
+    element = value;
+    element.set_prolog(in_prolog);
+    element.set_src_info(sref.src_whereis(pos));
+  }
+}
+
+void
+document_actions::insert_table(std::string const& name, iter_t const pos)
+{
+  extended_value const xval = local_lookup(name, pos);
+  if (!xval.is_a(fhicl::TABLE)) {
+    throw fhicl::exception(fhicl::error::type_mismatch, "@table::")
+      << "key \"" << name << "\" does not refer to a table at "
+      << sref.highlighted_whereis(pos) << "\n";
+  }
+  auto const& incoming = std::any_cast<table_t const&>(xval.value);
+  for (auto const& [name, value] : incoming) {
+    auto element = value;
+    element.set_prolog(in_prolog);
+    element.set_src_info(sref.src_whereis(pos));
+    tbl.insert(name, std::move(element));
+  }
+}
+
+void
+document_actions::seq_insert_sequence(std::string const& name,
+                                      sequence_t& v,
+                                      iter_t const pos)
+{
+  extended_value const xval = local_lookup(name, pos);
+  if (!xval.is_a(fhicl::SEQUENCE)) {
+    throw fhicl::exception(fhicl::error::type_mismatch, "@sequence::")
+      << "key \"" << name << "\" does not refer to a sequence at "
+      << sref.highlighted_whereis(pos) << "\n";
+  }
+  auto const& incoming = std::any_cast<sequence_t const&>(xval.value);
+  auto it = v.insert(v.end(), incoming.cbegin(), incoming.cend());
+  for (auto const e = v.end(); it != e; ++it) {
+    it->protection = Protection::NONE;
+    it->set_prolog(in_prolog);
+    it->set_src_info(sref.src_whereis(pos));
+  }
+}
+
+void
+document_actions::map_insert_loc(std::string const& name,
+                                 binding_modifier const m,
+                                 extended_value& value,
+                                 table_t& t,
+                                 iter_t const pos)
+try {
+  map_insert(name, m, value, t);
+}
+catch (fhicl::exception& e) {
+  throw fhicl::exception(fhicl::error::parse_error, "Error in assignment:", e)
+    << " at " << sref.highlighted_whereis(pos) << '\n';
+}
+
+void
+document_actions::map_erase_loc(std::string const& name,
+                                table_t& t,
+                                iter_t const pos)
+try {
+  map_erase(name, t);
+}
+catch (fhicl::exception& e) {
+  throw fhicl::exception(
+    fhicl::error::parse_error, "Error in erase attempt:", e)
+    << " at " << sref.highlighted_whereis(pos) << '\n';
+}
+
+void
+document_actions::tbl_erase(std::string const& name, iter_t const pos)
+try {
+  tbl.erase(name, in_prolog);
+}
+catch (fhicl::exception& e) {
+  throw fhicl::exception(
+    fhicl::error::parse_error, "Error in erase attempt:", e)
+    << " at " << sref.highlighted_whereis(pos) << '\n';
+}
+
+void
+document_actions::tbl_insert(std::string const& name,
+                             binding_modifier const m,
+                             extended_value& value,
+                             iter_t const pos)
+try {
+  set_protection(name, m, value);
+  tbl.insert(name, std::move(value));
+}
+catch (fhicl::exception& e) {
+  throw fhicl::exception(fhicl::error::parse_error, "Error in assignment:", e)
+    << " at " << sref.highlighted_whereis(pos) << '\n';
+}
+
+extended_value
+document_actions::xvalue_(value_tag const t, std::any v, iter_t const pos)
+{
+  return extended_value{in_prolog, t, std::move(v), sref.src_whereis(pos)};
+}
+
+// ======================================================================
@@ -0,0 +1,99 @@
+#ifndef fhiclcpp_detail_parse_actions_h
+#define fhiclcpp_detail_parse_actions_h
+
+// ======================================================================
+//
+// parse_actions: the semantic actions shared by the FHiCL parsers (see
+//                fhicl::parser_backend).
+//
+// The free functions canonicalize atoms and bind names to values
+// within a table, enforcing protections.  document_actions holds the
+// state of a document being parsed -- the intermediate_table and
+// whether a PROLOG is open -- and implements the operations upon it:
+// top-level bindings and erasures, @local::, @table:: and
+// @sequence::.  Errors are reported relative to positions in the
+// includer's text.
+//
+// ======================================================================
+
+#include "cetlib/includer.h"
+#include "fhiclcpp/detail/binding_modifier.h"
+#include "fhiclcpp/extended_value.h"
+#include "fhiclcpp/intermediate_table.h"
+
+#include <any>
+#include <string>
+
+namespace fhicl::detail {
+
+  std::string canon_nil();
+  std::string canon_inf(std::string const& inf);
+  std::string canon_num(std::string const& num);
+  std::string canon_str(std::string const& str);
+
+  void set_protection(std::string const& name,
+                      binding_modifier m,
+                      extended_value& v);
+
+  // Binding (and erasure) of a name within a table value.
+  void map_insert(std::string const& name,
+                  binding_modifier m,
+                  extended_value& value,
+                  extended_value::table_t& t);
+  void map_erase(std::string const& name, extended_value::table_t& t);
+
+  void seq_insert_value(extended_value xval, extended_value::sequence_t& v);
+
+  class document_actions {
+  public:
+    using iter_t = cet::includer::const_iterator;
+    using sequence_t = extended_value::sequence_t;
+    using table_t = extended_value::table_t;
+
+    explicit document_actions(cet::includer const& s) : sref{s} {}
+
+    extended_value local_lookup(std::string const& name, iter_t pos);
+    extended_value database_lookup(iter_t pos);
+
+    void insert_table_in_table(std::string const& name,
+                               table_t& t,
+                               iter_t pos);
+    void insert_table(std::string const& name, iter_t pos);
+    void seq_insert_sequence(std::string const& name,
+                             sequence_t& v,
+                             iter_t pos);
+
+    void map_insert_loc(std::string const& name,
+                        binding_modifier m,
+                        extended_value& value,
+                        table_t& t,
+                        iter_t pos);
+    void map_erase_loc(std::string const& name, table_t& t, iter_t pos);
+
+    void tbl_erase(std::string const& name, iter_t pos);
+    void tbl_insert(std::string const& name,
+                    binding_modifier m,
+                    extended_value& value,
+                    iter_t pos);
+
+    extended_value xvalue_(value_tag t, std::any v, iter_t pos);
+
+    void
+    set_in_prolog(bool const value)
+    {
+      in_prolog = value;
+    }
+
+    // data members:
+    bool in_prolog{false};
+    intermediate_table tbl{};
+    cet::includer const& sref;
+  };
+
+}
+
+#endif /* fhiclcpp_detail_parse_actions_h */
+
+// Local Variables:
+// mode: c++
+// End:
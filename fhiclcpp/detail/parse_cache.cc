@@ -0,0 +1,466 @@
+#include "fhiclcpp/detail/parse_cache.h"
+#include "fhiclcpp/detail/binary_codec.h"
+#include "fhiclcpp/exception.h"
+#include "fhiclcpp/parse_shims_opts.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+using fhicl::extended_value;
+using fhicl::intermediate_table;
+using fhicl::detail::parse_cache;
+using fhicl::detail::replaying_maker;
+using fhicl::detail::write_bytes;
+using fhicl::detail::write_count;
+
+// The binary form of an intermediate_table:
+//
+//   bytes   := magic version table
+//   magic   := "\x7fFHI" (which cannot begin a FHiCL document)
+//   version := 1 byte
+//   table   := count (string value)*      entries in iteration order
+//   value   := tag flags string payload   tag, flags, source info
+//   tag     := 1 byte, the value_tag
+//   flags   := 1 byte: bit 0 in_prolog, bits 1-2 protection
+//   payload := string                     atom (NIL, BOOL, NUMBER,
+//                                         STRING, TABLEID)
+//            | string string              COMPLEX
+//            | count value*               SEQUENCE
+//            | table                      TABLE
+//   string  := count byte*
+//   count   := unsigned LEB128
+
+namespace {
+  constexpr std::string_view binary_magic{"\x7f"
+                                          "FHI"};
+  constexpr unsigned char binary_version{1};
+
+  // Include directives are recognized as by cet::includer.
+  constexpr std::string_view include_directive{"#include \""};
+
+  // Deeper nesting is most likely recursion, which is left for the
+  // includer to diagnose.
+  constexpr unsigned max_include_depth{64};
+
+  std::string
+  as_string(parse_cache::key_t const& digest)
+  {
+    return std::string(reinterpret_cast<char const*>(digest.data()),
+                       digest.size());
+  }
+
+  bool
+  current_stamp(std::string const& path,
+                long long& mtime,
+                std::size_t& size)
+  {
+    std::error_code ec;
+    auto const t = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+      return false;
+    }
+    auto const sz = std::filesystem::file_size(path, ec);
+    if (ec) {
+      return false;
+    }
+    mtime = t.time_since_epoch().count();
+    size = sz;
+    return true;
+  }
+
+  void write_table(std::string& out, extended_value::table_t const& t);
+
+  void
+  write_value(std::string& out, extended_value const& v)
+  {
+    out.push_back(static_cast<char>(v.tag));
+    out.push_back(static_cast<char>(
+      (v.in_prolog ? 1 : 0) | (static_cast<unsigned>(v.protection) << 1)));
+    write_bytes(out, v.src_info);
+    switch (v.tag) {
+    case fhicl::COMPLEX: {
+      auto const& [re, im] =
+        std::any_cast<extended_value::complex_t const&>(v.value);
+      write_bytes(out, re);
+      write_bytes(out, im);
+      break;
+    }
+    case fhicl::SEQUENCE: {
+      auto const& seq =
+        std::any_cast<extended_value::sequence_t const&>(v.value);
+      write_count(out, seq.size());
+      for (auto const& element : seq) {
+        write_value(out, element);
+      }
+      break;
+    }
+    case fhicl::TABLE:
+      write_table(out,
+                  std::any_cast<extended_value::table_t const&>(v.value));
+      break;
+    case fhicl::UNKNOWN:
+      break;
+    default:
+      write_bytes(out, std::any_cast<extended_value::atom_t const&>(v.value));
+    }
+  }
+
+  void
+  write_table(std::string& out, extended_value::table_t const& t)
+  {
+    write_count(out, t.size());
+    for (auto const& [name, value] : t) {
+      write_bytes(out, name);
+      write_value(out, value);
+    }
+  }
+
+  class binary_reader : fhicl::detail::binary_decoder {
+  public:
+    explicit binary_reader(std::string_view const bytes)
+      : binary_decoder{bytes, "cached intermediate_table: "}
+    {}
+
+    extended_value::table_t
+    table()
+    {
+      extended_value::table_t result;
+      for (auto n = count(); n != 0; --n) {
+        auto name = string();
+        result.emplace(std::move(name), value());
+      }
+      return result;
+    }
+
+    using binary_decoder::expect_end;
+
+  private:
+    extended_value
+    value()
+    {
+      auto const tag = byte();
+      auto const flags = byte();
+      if (tag > fhicl::TABLEID || (flags >> 1) > 2) {
+        unread();
+        fail("unknown value tag or flags");
+      }
+      bool const in_prolog = flags & 1;
+      auto const protection = static_cast<fhicl::Protection>(flags >> 1);
+      auto src = string();
+      auto const vtag = static_cast<fhicl::value_tag>(tag);
+      std::any payload;
+      switch (vtag) {
+      case fhicl::COMPLEX: {
+        auto re = string();
+        payload = extended_value::complex_t{std::move(re), string()};
+        break;
+      }
+      case fhicl::SEQUENCE: {
+        auto n = count();
+        extended_value::sequence_t seq;
+        seq.reserve(std::min(n, remaining()));
+        for (; n != 0; --n) {
+          seq.push_back(value());
+        }
+        payload = std::move(seq);
+        break;
+      }
+      case fhicl::TABLE:
+        payload = table();
+        break;
+      case fhicl::UNKNOWN:
+        break;
+      default:
+        payload = string();
+      }
+      return extended_value{
+        in_prolog, vtag, std::move(payload), protection, std::move(src)};
+    }
+  };
+}
+
+// ----------------------------------------------------------------------
+
+std::string
+replaying_maker::operator()(std::string const& filename)
+{
+  if (!diverged_ && next_ != resolutions_.size() &&
+      resolutions_[next_].name == filename) {
+    auto const& r = resolutions_[next_++];
+    if (r.error) {
+      std::rethrow_exception(r.error);
+    }
+    return r.path;
+  }
+  diverged_ = true;
+  return maker_(filename);
+}
+
+// ----------------------------------------------------------------------
+
+parse_cache::parse_cache(std::size_t const max_documents,
+                         std::string directory)
+  : max_documents_{max_documents}, directory_{std::move(directory)}
+{
+  if (!directory_.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (!std::filesystem::is_directory(directory_)) {
+      throw fhicl::exception(fhicl::error::cant_open_db,
+                             "Can't use parse cache directory")
+        << directory_ << '\n';
+    }
+  }
+}
+
+parse_cache::lookup_result
+parse_cache::lookup(std::string const& filename, cet::filepath_maker& maker)
+{
+  lookup_result result;
+  cet::sha1 key{"fhiclcpp parse cache 1"};
+  key << (shims::isSnippetMode() ? 's' : 'n');
+  if (!scan_(filename, maker, 0, key, result)) {
+    return result;
+  }
+  result.key = key.digest();
+  result.table = find_(*result.key);
+
+  std::lock_guard const lock{mutex_};
+  ++(result.table ? hits_ : misses_);
+  return result;
+}
+
+bool
+parse_cache::scan_(std::string const& name,
+                   cet::filepath_maker& maker,
+                   unsigned const depth,
+                   cet::sha1& key,
+                   lookup_result& result)
+{
+  if (depth > max_include_depth) {
+    return false;
+  }
+  auto& r = result.resolutions.emplace_back(resolution{name, {}});
+  try {
+    r.path = maker(name);
+  }
+  catch (...) {
+    r.error = std::current_exception();
+    return false;
+  }
+  auto const path = r.path; // r is invalidated by further resolutions.
+  auto const info = file_info_(path);
+  if (!info) {
+    return false;
+  }
+  result.stamps.push_back({path, info->mtime, info->size});
+  key << name << '\0' << path << '\0' << as_string(info->digest);
+  return std::all_of(
+    info->includes.begin(),
+    info->includes.end(),
+    [this, &maker, depth, &key, &result](std::string const& included) {
+      return scan_(included, maker, depth + 1, key, result);
+    });
+}
+
+std::optional<parse_cache::file_info>
+parse_cache::file_info_(std::string const& path)
+{
+  file_info info;
+  if (!current_stamp(path, info.mtime, info.size)) {
+    return std::nullopt;
+  }
+  {
+    std::lock_guard const lock{mutex_};
+    if (auto const it = files_.find(path);
+        it != files_.end() && it->second.mtime == info.mtime &&
+        it->second.size == info.size) {
+      return it->second;
+    }
+  }
+
+  std::ifstream in{path, std::ios::binary};
+  std::string const text{std::istreambuf_iterator<char>{in},
+                         std::istreambuf_iterator<char>{}};
+  if (!in) {
+    return std::nullopt;
+  }
+  info.size = text.size();
+  info.digest = cet::sha1{text}.digest();
+  std::istringstream lines{text};
+  for (std::string line; std::getline(lines, line);) {
+    if (!line.starts_with(include_directive)) {
+      continue;
+    }
+    auto const close = line.find('"', include_directive.size());
+    if (close == std::string::npos) {
+      return std::nullopt; // Malformed: for the includer to diagnose.
+    }
+    info.includes.push_back(line.substr(
+      include_directive.size(), close - include_directive.size()));
+  }
+
+  std::lock_guard const lock{mutex_};
+  return files_.insert_or_assign(path, std::move(info)).first->second;
+}
+
+void
+parse_cache::store(lookup_result const& lookup, intermediate_table const& tbl)
+{
+  if (!lookup.key) {
+    return;
+  }
+  for (auto const& s : lookup.stamps) {
+    long long mtime{};
+    std::size_t size{};
+    if (!current_stamp(s.path, mtime, size) || mtime != s.mtime ||
+        size != s.size) {
+      return;
+    }
+  }
+  remember_(*lookup.key, tbl);
+  if (directory_.empty()) {
+    return;
+  }
+
+  // A cache that cannot be written is simply not used.
+  auto const filename = filename_(*lookup.key);
+  std::ostringstream suffix;
+  suffix << ".tmp." << ::getpid() << '.'
+         << std::hash<std::thread::id>{}(std::this_thread::get_id());
+  auto const tmpname = filename + suffix.str();
+  auto const bytes = to_binary(tbl);
+  {
+    std::ofstream out{tmpname, std::ios::binary | std::ios::trunc};
+    out.write(bytes.data(), bytes.size());
+    out.close();
+    if (!out) {
+      std::error_code ec;
+      std::filesystem::remove(tmpname, ec);
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmpname, filename, ec);
+}
+
+std::optional<intermediate_table>
+parse_cache::find_(key_t const& key)
+{
+  {
+    std::lock_guard const lock{mutex_};
+    if (auto const it = index_.find(key); it != index_.end()) {
+      documents_.splice(documents_.begin(), documents_, it->second);
+      return it->second->second;
+    }
+  }
+  if (directory_.empty()) {
+    return std::nullopt;
+  }
+
+  std::ifstream in{filename_(key), std::ios::binary};
+  if (!in) {
+    return std::nullopt;
+  }
+  std::string const bytes{std::istreambuf_iterator<char>{in},
+                          std::istreambuf_iterator<char>{}};
+  try {
+    auto result = from_binary(bytes);
+    remember_(key, result);
+    return result;
+  }
+  catch (fhicl::exception const&) {
+    return std::nullopt; // Unreadable: to be replaced.
+  }
+}
+
+void
+parse_cache::remember_(key_t const& key, intermediate_table const& tbl)
+{
+  std::lock_guard const lock{mutex_};
+  if (auto const it = index_.find(key); it != index_.end()) {
+    documents_.erase(it->second);
+    index_.erase(it);
+  }
+  if (max_documents_ == 0) {
+    return;
+  }
+  while (documents_.size() >= max_documents_) {
+    index_.erase(documents_.back().first);
+    documents_.pop_back();
+  }
+  documents_.emplace_front(key, tbl);
+  index_.emplace(key, documents_.begin());
+}
+
+std::string
+parse_cache::filename_(key_t const& key) const
+{
+  static constexpr char hex[]{"0123456789abcdef"};
+  std::string result{directory_};
+  result += '/';
+  for (auto const byte : key) {
+    result += hex[byte >> 4];
+    result += hex[byte & 0xf];
+  }
+  return result += ".fhit";
+}
+
+std::size_t
+parse_cache::hits() const
+{
+  std::lock_guard const lock{mutex_};
+  return hits_;
+}
+
+std::size_t
+parse_cache::misses() const
+{
+  std::lock_guard const lock{mutex_};
+  return misses_;
+}
+
+// ----------------------------------------------------------------------
+
+std::string
+parse_cache::to_binary(intermediate_table const& tbl)
+{
+  std::string result{binary_magic};
+  result.push_back(static_cast<char>(binary_version));
+  write_count(result, std::distance(tbl.begin(), tbl.end()));
+  for (auto const& [name, value] : tbl) {
+    write_bytes(result, name);
+    write_value(result, value);
+  }
+  return result;
+}
+
+intermediate_table
+parse_cache::from_binary(std::string_view const bytes)
+{
+  if (!bytes.starts_with(binary_magic) ||
+      bytes.size() == binary_magic.size() ||
+      static_cast<unsigned char>(bytes[binary_magic.size()]) !=
+        binary_version) {
+    throw fhicl::exception(fhicl::error::parse_error,
+                           "cached intermediate_table: ")
+      << "not a cached intermediate_table, or an unsupported version.\n";
+  }
+  binary_reader reader{bytes.substr(binary_magic.size() + 1)};
+  auto entries = reader.table();
+  reader.expect_end();
+
+  intermediate_table result;
+  for (auto& [name, value] : entries) {
+    result.insert(name, std::move(value));
+  }
+  return result;
+}
@@ -0,0 +1,149 @@
+#ifndef fhiclcpp_detail_parse_cache_h
+#define fhiclcpp_detail_parse_cache_h
+
+// ======================================================================
+//
+// parse_cache: results of parse_document(filename, maker), reused when
+//              none of the files making up the document has changed
+//              (see fhicl::enable_parse_cache).
+//
+// A document is identified by the files cet::includer would read for
+// it: for each, in the order read, the name asked of the
+// filepath_maker, the path it resolved to, and the SHA-1 digest of the
+// file's contents.  Each file's digest and #include directives are
+// remembered, and recomputed only if its modification time or size
+// changes.
+//
+// Resolving a name may change the state of a filepath_maker (e.g. the
+// first lookup may be treated specially), so the includer is handed a
+// replaying_maker that returns the resolutions already made.  A result
+// is kept only if the includer asked for exactly those names, in that
+// order: only then is the identification known to be complete.
+//
+// Results are held in memory, the least recently used being dropped
+// beyond a maximum count, and optionally also as files in a directory,
+// where they survive the process.  Files in the directory are written
+// under a temporary name that is then renamed into place.
+//
+// ======================================================================
+
+#include "cetlib/filepath_maker.h"
+#include "cetlib/sha1.h"
+#include "fhiclcpp/intermediate_table.h"
+
+#include <cstddef>
+#include <exception>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fhicl::detail {
+
+  class parse_cache {
+  public:
+    using key_t = cet::sha1::digest_t;
+
+    struct resolution {
+      std::string name;
+      std::string path;
+      std::exception_ptr error{}; // If resolving name threw.
+    };
+
+    struct stamp {
+      std::string path;
+      long long mtime;
+      std::size_t size;
+    };
+
+    struct lookup_result {
+      std::optional<key_t> key{}; // None if not identifiable.
+      std::vector<resolution> resolutions{};
+      std::vector<stamp> stamps{};
+      std::optional<intermediate_table> table{}; // The cached result.
+    };
+
+    parse_cache(std::size_t max_documents, std::string directory);
+
+    // Identifies the document, resolving its file names with maker,
+    // and returns any result cached for it.
+    lookup_result lookup(std::string const& filename,
+                         cet::filepath_maker& maker);
+
+    // Keeps tbl as the result for the identified document, unless one
+    // of its files has changed since it was identified.
+    void store(lookup_result const& lookup, intermediate_table const& tbl);
+
+    std::size_t hits() const;
+    std::size_t misses() const;
+
+    // The binary form in which results are kept on disk.
+    static std::string to_binary(intermediate_table const& tbl);
+    static intermediate_table from_binary(std::string_view bytes);
+
+  private:
+    struct file_info {
+      long long mtime;
+      std::size_t size;
+      key_t digest;
+      std::vector<std::string> includes;
+    };
+
+    bool scan_(std::string const& name,
+               cet::filepath_maker& maker,
+               unsigned depth,
+               cet::sha1& key,
+               lookup_result& result);
+    std::optional<file_info> file_info_(std::string const& path);
+
+    std::optional<intermediate_table> find_(key_t const& key);
+    void remember_(key_t const& key, intermediate_table const& tbl);
+    std::string filename_(key_t const& key) const;
+
+    std::size_t const max_documents_;
+    std::string const directory_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, file_info> files_;
+    std::list<std::pair<key_t, intermediate_table>> documents_; // MRU first.
+    std::map<key_t, decltype(documents_)::iterator> index_;
+    std::size_t hits_{};
+    std::size_t misses_{};
+  };
+
+  // Returns the resolutions recorded by parse_cache::lookup, in order,
+  // deferring to the original maker for anything else.
+  class replaying_maker : public cet::filepath_maker {
+  public:
+    replaying_maker(std::vector<parse_cache::resolution> const& resolutions,
+                    cet::filepath_maker& maker)
+      : resolutions_{resolutions}, maker_{maker}
+    {}
+
+    std::string operator()(std::string const& filename) override;
+
+    // Whether every recorded resolution, and nothing else, was asked for.
+    bool
+    replayed_exactly() const noexcept
+    {
+      return !diverged_ && next_ == resolutions_.size();
+    }
+
+  private:
+    std::vector<parse_cache::resolution> const& resolutions_;
+    cet::filepath_maker& maker_;
+    std::size_t next_{};
+    bool diverged_{false};
+  };
+
+}
+
+#endif /* fhiclcpp_detail_parse_cache_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,806 @@
+// ======================================================================
+//
+// recursive_descent_parser
+//
+// A hand-written lexer and parser for the language of the Boost.Spirit
+// grammar in parse.cc, producing identical results via the same
+// semantic actions (parse_actions).  The grammar's alternatives are
+// tried in the grammar's order, but each is rejected by at most its
+// first token -- mostly its first character -- so the input is
+// scanned essentially once, and values are moved rather than copied
+// into their enclosing sequences and tables.
+//
+// As in the grammar, there are two kinds of failure.  A construct that
+// does not match returns false, leaving the position where it was so
+// that the next alternative may be tried.  Once a construct is
+// committed to (the grammar's expectation points, e.g. after an
+// opening '['), a failure throws a syntax_error recording where it was
+// detected.
+//
+// ======================================================================
+
+#include "fhiclcpp/detail/recursive_descent_parser.h"
+
+#include "cetlib/canonical_number.h"
+#include "fhiclcpp/detail/parse_actions.h"
+#include "fhiclcpp/extended_value.h"
+#include "fhiclcpp/intermediate_table.h"
+#include "fhiclcpp/parse_shims_opts.h"
+
+#include <algorithm>
+#include <any>
+#include <string_view>
+#include <utility>
+
+using namespace fhicl;
+using namespace fhicl::detail;
+using atom_t = extended_value::atom_t;
+using complex_t = extended_value::complex_t;
+using sequence_t = extended_value::sequence_t;
+using table_t = extended_value::table_t;
+using iter_t = std::string::const_iterator;
+
+namespace {
+
+  // The ASCII character classes of the grammar.
+  constexpr bool
+  is_space(char const c)
+  {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+  constexpr bool
+  is_graph(char const c)
+  {
+    return c > ' ' && c < '\x7f';
+  }
+
+  constexpr bool
+  is_digit(char const c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  constexpr bool
+  is_word(char const c)
+  {
+    return is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '_';
+  }
+
+  constexpr bool
+  is_xdigit(char const c)
+  {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+  }
+
+  // The token terminators of tokens.h.
+  constexpr bool
+  munched(char const c)
+  {
+    return !is_graph(c) || c == '#' || c == '/' || c == ',' || c == ']' ||
+           c == '}';
+  }
+
+  constexpr bool
+  munched_number(char const c)
+  {
+    return munched(c) || c == ')';
+  }
+
+  constexpr bool
+  munched_ass(char const c)
+  {
+    return munched(c) || c == '.' || c == '[' || c == ':';
+  }
+
+  std::string
+  keyword(std::string kw)
+  {
+    // See shims::lit.
+    if (shims::isSnippetMode()) {
+      kw[0] = '!';
+    }
+    return kw;
+  }
+
+  struct syntax_error {
+    iter_t where;
+  };
+
+  class parser {
+  public:
+    // Without a document, only values are parsed (parse_value_string):
+    // @local::, @db::, @sequence:: and @table:: are not recognized, and
+    // values carry no source information.
+    parser(iter_t const begin, iter_t const end, document_actions* const doc)
+      : pos_{begin}, end_{end}, doc_{doc}
+    {}
+
+    iter_t
+    position() const
+    {
+      return pos_;
+    }
+
+    void skip();
+    void document();
+    bool value(extended_value& result);
+
+  private:
+    bool
+    at(char const c) const
+    {
+      return pos_ != end_ && *pos_ == c;
+    }
+
+    bool
+    starts_with(iter_t const it, std::string_view const s) const
+    {
+      return static_cast<std::size_t>(end_ - it) >= s.size() &&
+             std::equal(s.begin(), s.end(), it);
+    }
+
+    // Match s here, without skipping.
+    bool
+    lit(std::string_view const s)
+    {
+      if (!starts_with(pos_, s)) {
+        return false;
+      }
+      pos_ += s.size();
+      return true;
+    }
+
+    void
+    expect(char const c)
+    {
+      skip();
+      if (!at(c)) {
+        throw syntax_error{pos_};
+      }
+      ++pos_;
+    }
+
+    // !(graph - char_(also)) at it.
+    bool
+    terminated(iter_t const it, std::string_view const also) const
+    {
+      return it == end_ || !is_graph(*it) || also.find(*it) != also.npos;
+    }
+
+    bool
+    ends_token(iter_t const it, bool (*munched)(char)) const
+    {
+      return it == end_ || munched(*it);
+    }
+
+    // Tokens, none of which skips; each leaves the position unchanged
+    // if it does not match.
+    bool ass(std::string& result);
+    bool dss(std::string& result);
+    bool uint(std::string& result);
+    bool real(std::string& result);
+    bool radix(char prefix, bool (*is_radix_digit)(char), std::string& result);
+    bool inf(std::string& result);
+    bool dbid(std::string& result);
+    bool squoted(std::string& result);
+    bool dquoted(std::string& result);
+    bool catchall(std::string& result);
+    bool number(atom_t& result);
+    bool string(atom_t& result);
+
+    bool qualname(std::string& result);
+    std::string noskip_qualname();
+    void qualname_tail(std::string& result);
+    bool binding(binding_modifier& result);
+
+    bool statement();
+    void sequence(sequence_t& result);
+    bool element(sequence_t& result);
+    void table(table_t& result);
+    bool entry(table_t& result);
+
+    bool
+    make_value(extended_value& result,
+               value_tag const tag,
+               std::any value,
+               iter_t const pos)
+    {
+      result = doc_ ? doc_->xvalue_(tag, std::move(value), pos) :
+                      extended_value{false, tag, std::move(value)};
+      return true;
+    }
+
+    iter_t pos_;
+    iter_t const end_;
+    document_actions* const doc_;
+    bool const snippet_{shims::isSnippetMode()};
+    std::string const local_kw_{keyword("@local::")};
+    std::string const db_kw_{keyword("@db::")};
+    std::string const id_kw_{keyword("@id::")};
+    std::string const table_kw_{keyword("@table::")};
+    std::string const sequence_kw_{keyword("@sequence::")};
+    std::string const erase_kw_{keyword("@erase")};
+  };
+
+  // --------------------------------------------------------------------
+
+  void
+  parser::skip()
+  {
+    while (pos_ != end_) {
+      if (is_space(*pos_)) {
+        ++pos_;
+        continue;
+      }
+      iter_t text;
+      if (*pos_ == '#') {
+        text = pos_ + 1;
+      } else if (starts_with(pos_, "//")) {
+        text = pos_ + 2;
+      } else {
+        return;
+      }
+      // A comment is skipped only if its line is terminated.
+      auto const eol = std::find_if(
+        text, end_, [](char const c) { return c == '\n' || c == '\r'; });
+      if (eol == end_) {
+        return;
+      }
+      pos_ = eol + 1;
+    }
+  }
+
+  bool
+  parser::ass(std::string& result)
+  {
+    auto const it = std::find_if_not(pos_, end_, is_word);
+    if (it == pos_ || is_digit(*pos_) || !ends_token(it, munched_ass)) {
+      return false;
+    }
+    result.assign(pos_, it);
+    pos_ = it;
+    return true;
+  }
+
+  bool
+  parser::dss(std::string& result)
+  {
+    auto const it = std::find_if_not(pos_, end_, is_word);
+    if (it == pos_ || !is_digit(*pos_) || std::all_of(pos_, it, is_digit) ||
+        !ends_token(it, munched)) {
+      return false;
+    }
+    result.assign(pos_, it);
+    pos_ = it;
+    return true;
+  }
+
+  bool
+  parser::uint(std::string& result)
+  {
+    auto const it = std::find_if_not(pos_, end_, is_digit);
+    if (it == pos_ || !ends_token(it, munched_number)) {
+      return false;
+    }
+    // Leading zeros are dropped.
+    auto const first = std::find_if(
+      pos_, it - 1, [](char const c) { return c != '0'; });
+    result.assign(first, it);
+    pos_ = it;
+    return true;
+  }
+
+  bool
+  parser::real(std::string& result)
+  {
+    static constexpr std::string_view allowed{"0123456789.-+eE"};
+    auto const it = std::find_if_not(pos_, end_, [](char const c) {
+      return allowed.find(c) != allowed.npos;
+    });
+    if (it == pos_ || !ends_token(it, munched_number)) {
+      return false;
+    }
+    std::string canonical;
+    if (!cet::canonical_number(std::string(pos_, it), canonical)) {
+      return false;
+    }
+    result = std::move(canonical);
+    pos_ = it;
+    return true;
+  }
+
+  // Hexadecimal (0x...) and binary (0b...) numbers.
+  bool
+  parser::radix(char const prefix,
+                bool (*is_radix_digit)(char),
+                std::string& result)
+  {
+    if (!at('0') || pos_ + 1 == end_ || (pos_[1] | 0x20) != prefix) {
+      return false;
+    }
+    auto const it = std::find_if_not(pos_ + 2, end_, is_radix_digit);
+    if (it == pos_ + 2 || !ends_token(it, munched_number)) {
+      return false;
+    }
+    std::string canonical;
+    if (!cet::canonical_number(std::string(pos_, it), canonical)) {
+      return false;
+    }
+    result = std::move(canonical);
+    pos_ = it;
+    return true;
+  }
+
+  bool
+  parser::inf(std::string& result)
+  {
+    auto it = pos_;
+    if (at('+') || at('-')) {
+      ++it;
+    }
+    if (!starts_with(it, "infinity") || !terminated(it + 8, "),]}")) {
+      return false;
+    }
+    result.assign(pos_, it + 8);
+    pos_ = it + 8;
+    return true;
+  }
+
+  bool
+  parser::dbid(std::string& result)
+  {
+    auto const it = std::find_if_not(pos_, end_, is_xdigit);
+    if (!ends_token(it, munched_number) ||
+        static_cast<std::size_t>(it - pos_) != ParameterSetID::max_str_size()) {
+      return false;
+    }
+    result.assign(pos_, it);
+    pos_ = it;
+    return true;
+  }
+
+  bool
+  parser::squoted(std::string& result)
+  {
+    if (!at('\'')) {
+      return false;
+    }
+    auto const close = std::find(pos_ + 1, end_, '\'');
+    if (close == end_ || !terminated(close + 1, ",]}")) {
+      return false;
+    }
+    result.assign(pos_, close + 1);
+    pos_ = close + 1;
+    return true;
+  }
+
+  bool
+  parser::dquoted(std::string& result)
+  {
+    if (!at('"')) {
+      return false;
+    }
+    auto it = pos_ + 1;
+    while (it != end_ && *it != '"') {
+      // An escaped quote does not close the string.
+      it += (*it == '\\' && it + 1 != end_ && it[1] == '"') ? 2 : 1;
+    }
+    if (it == end_ || !terminated(it + 1, ",]}")) {
+      return false;
+    }
+    result.assign(pos_, it + 1);
+    pos_ = it + 1;
+    return true;
+  }
+
+  bool
+  parser::catchall(std::string& result)
+  {
+    // See shims::catchall_parser.
+    auto const it = std::find_if_not(pos_, end_, [](char const c) {
+      return is_word(c) || c == ':' || c == '@';
+    });
+    if (it == pos_ || is_digit(*pos_) || !ends_token(it, munched_ass)) {
+      return false;
+    }
+    result.assign(pos_, it);
+    pos_ = it;
+    return true;
+  }
+
+  bool
+  parser::number(atom_t& result)
+  {
+    std::string token;
+    if (uint(token)) {
+      result = canon_num(token);
+      return true;
+    }
+    if (inf(token)) {
+      result = canon_inf(token);
+      return true;
+    }
+    return real(result) || radix('x', is_xdigit, result) ||
+           radix(
+             'b', [](char const c) { return c == '0' || c == '1'; }, result);
+  }
+
+  bool
+  parser::string(atom_t& result)
+  {
+    std::string token;
+    if (ass(token) || dss(token) || squoted(token) || dquoted(token)) {
+      result = canon_str(token);
+      return true;
+    }
+    return false;
+  }
+
+  // --------------------------------------------------------------------
+
+  bool
+  parser::qualname(std::string& result)
+  {
+    skip();
+    if (!ass(result)) {
+      return false;
+    }
+    qualname_tail(result);
+    return true;
+  }
+
+  // Whitespace is permitted only around the delimiters.
+  std::string
+  parser::noskip_qualname()
+  {
+    std::string result;
+    if (!ass(result)) {
+      throw syntax_error{pos_};
+    }
+    qualname_tail(result);
+    return result;
+  }
+
+  void
+  parser::qualname_tail(std::string& result)
+  {
+    for (;;) {
+      auto const save = pos_;
+      skip();
+      std::string part;
+      if (at('.')) {
+        ++pos_;
+        skip();
+        if (!ass(part)) {
+          throw syntax_error{pos_};
+        }
+        result += '.';
+        result += part;
+      } else if (at('[')) {
+        ++pos_;
+        skip();
+        if (!uint(part)) {
+          throw syntax_error{pos_};
+        }
+        expect(']');
+        result += '[';
+        result += part;
+        result += ']';
+      } else {
+        pos_ = save;
+        return;
+      }
+    }
+  }
+
+  bool
+  parser::binding(binding_modifier& result)
+  {
+    static constexpr std::pair<std::string_view, binding_modifier> modifiers[]{
+      {"@protect_ignore", binding_modifier::PROTECT_IGNORE},
+      {"@protect_error", binding_modifier::PROTECT_ERROR}};
+    skip();
+    if (at(':')) {
+      ++pos_;
+      result = binding_modifier::NONE;
+      return true;
+    }
+    for (auto const& [modifier, value] : modifiers) {
+      auto const colon = pos_ + modifier.size();
+      if (starts_with(pos_, modifier) && colon != end_ && *colon == ':') {
+        pos_ = colon + 1;
+        result = value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // --------------------------------------------------------------------
+
+  void
+  parser::document()
+  {
+    for (;;) {
+      skip();
+      if (!lit("BEGIN_PROLOG")) {
+        break;
+      }
+      doc_->set_in_prolog(true);
+      while (statement()) {
+      }
+      skip();
+      if (!lit("END_PROLOG")) {
+        throw syntax_error{pos_};
+      }
+      doc_->set_in_prolog(false);
+    }
+    while (statement()) {
+    }
+    skip();
+  }
+
+  bool
+  parser::statement()
+  {
+    skip();
+    auto const start = pos_;
+    std::string name;
+    if (qualname(name)) {
+      auto const after_name = pos_;
+      binding_modifier m;
+      extended_value v;
+      if (binding(m) && value(v)) {
+        doc_->tbl_insert(name, m, v, start);
+        return true;
+      }
+      pos_ = after_name;
+      skip();
+      if (at(':')) {
+        ++pos_;
+        skip();
+        if (!lit(erase_kw_)) {
+          throw syntax_error{pos_};
+        }
+        doc_->tbl_erase(name, start);
+        return true;
+      }
+    }
+    pos_ = start;
+    if (lit(table_kw_)) {
+      doc_->insert_table(noskip_qualname(), start);
+      return true;
+    }
+    return false;
+  }
+
+  bool
+  parser::value(extended_value& result)
+  {
+    skip();
+    auto const start = pos_;
+    if (pos_ == end_) {
+      return false;
+    }
+    atom_t atom;
+    if (starts_with(pos_, "@nil") && terminated(pos_ + 4, ",]}")) {
+      pos_ += 4;
+      return make_value(result, NIL, canon_nil(), start);
+    }
+    for (std::string_view const b : {"true", "false"}) {
+      if (starts_with(pos_, b) && terminated(pos_ + b.size(), ",]}")) {
+        pos_ += b.size();
+        return make_value(result, BOOL, atom_t{b}, start);
+      }
+    }
+    if (number(atom)) {
+      return make_value(result, NUMBER, std::move(atom), start);
+    }
+    if (at('(')) {
+      ++pos_;
+      complex_t c;
+      skip();
+      if (!number(c.first)) {
+        throw syntax_error{pos_};
+      }
+      expect(',');
+      skip();
+      if (!number(c.second)) {
+        throw syntax_error{pos_};
+      }
+      expect(')');
+      return make_value(result, COMPLEX, std::move(c), start);
+    }
+    if (string(atom)) {
+      return make_value(result, STRING, std::move(atom), start);
+    }
+    if (doc_) {
+      if (lit(local_kw_)) {
+        result = doc_->local_lookup(noskip_qualname(), start);
+        return true;
+      }
+      if (lit(db_kw_)) {
+        noskip_qualname();
+        result = doc_->database_lookup(start);
+        return true;
+      }
+    }
+    if (lit(id_kw_)) {
+      if (!dbid(atom)) {
+        throw syntax_error{pos_};
+      }
+      return make_value(result, TABLEID, std::move(atom), start);
+    }
+    if (at('[')) {
+      sequence_t s;
+      sequence(s);
+      return make_value(result, SEQUENCE, std::move(s), start);
+    }
+    if (at('{')) {
+      table_t t;
+      table(t);
+      return make_value(result, TABLE, std::move(t), start);
+    }
+    if (snippet_ && catchall(atom)) {
+      return make_value(result, STRING, canon_str(atom), start);
+    }
+    return false;
+  }
+
+  void
+  parser::sequence(sequence_t& result)
+  {
+    ++pos_;
+    if (!doc_) {
+      // value % ','
+      extended_value v;
+      if (value(v)) {
+        result.push_back(std::move(v));
+        for (;;) {
+          auto const save = pos_;
+          skip();
+          if (!at(',')) {
+            break;
+          }
+          ++pos_;
+          if (!value(v)) {
+            pos_ = save;
+            break;
+          }
+          result.push_back(std::move(v));
+        }
+      }
+      expect(']');
+      return;
+    }
+    element(result);
+    for (;;) {
+      skip();
+      if (!at(',')) {
+        break;
+      }
+      auto const after_comma = ++pos_;
+      if (!element(result)) {
+        throw syntax_error{after_comma};
+      }
+    }
+    expect(']');
+  }
+
+  bool
+  parser::element(sequence_t& result)
+  {
+    extended_value v;
+    if (value(v)) {
+      seq_insert_value(std::move(v), result);
+      return true;
+    }
+    skip();
+    auto const start = pos_;
+    if (!lit(sequence_kw_)) {
+      return false;
+    }
+    doc_->seq_insert_sequence(noskip_qualname(), result, start);
+    return true;
+  }
+
+  void
+  parser::table(table_t& result)
+  {
+    ++pos_;
+    while (entry(result)) {
+    }
+    expect('}');
+  }
+
+  bool
+  parser::entry(table_t& result)
+  {
+    skip();
+    auto const start = pos_;
+    std::string name;
+    if (ass(name)) {
+      auto const after_name = pos_;
+      binding_modifier m;
+      extended_value v;
+      if (binding(m) && value(v)) {
+        if (doc_) {
+          doc_->map_insert_loc(name, m, v, result, start);
+        } else {
+          map_insert(name, m, v, result);
+        }
+        return true;
+      }
+      pos_ = after_name;
+      skip();
+      if (at(':')) {
+        ++pos_;
+        skip();
+        if (!lit(erase_kw_)) {
+          throw syntax_error{pos_};
+        }
+        if (doc_) {
+          doc_->map_erase_loc(name, result, start);
+        } else {
+          map_erase(name, result);
+        }
+        return true;
+      }
+    }
+    pos_ = start;
+    if (doc_ && lit(table_kw_)) {
+      doc_->insert_table_in_table(noskip_qualname(), result, start);
+      return true;
+    }
+    return false;
+  }
+
+}
+
+// ----------------------------------------------------------------------
+
+bool
+fhicl::detail::rd_parse_document(cet::includer const& s,
+                                 intermediate_table& tbl,
+                                 cet::includer::const_iterator& stop)
+{
+  document_actions actions{s};
+  parser p{s.begin(), s.end(), &actions};
+  try {
+    p.document();
+  }
+  catch (syntax_error const& e) {
+    stop = e.where;
+    return false;
+  }
+  stop = p.position();
+  tbl = std::move(actions.tbl);
+  return true;
+}
+
+bool
+fhicl::detail::rd_parse_value_string(std::string const& s,
+                                     extended_value& result,
+                                     std::string& unparsed)
+{
+  parser p{s.cbegin(), s.cend(), nullptr};
+  auto stop = s.cbegin();
+  bool parsed = false;
+  try {
+    parsed = p.value(result);
+    if (parsed) {
+      p.skip();
+      stop = p.position();
+    }
+  }
+  catch (syntax_error const& e) {
+    unparsed.assign(e.where, s.cend());
+    return false;
+  }
+  unparsed.assign(stop, s.cend());
+  return parsed && stop == s.cend();
+}
+
+// ======================================================================
@@ -0,0 +1,39 @@
+#ifndef fhiclcpp_detail_recursive_descent_parser_h
+#define fhiclcpp_detail_recursive_descent_parser_h
+
+// ======================================================================
+//
+// recursive_descent_parser: the hand-written implementation of
+//                           parse_document and parse_value_string
+//                           (see fhicl::parser_backend).
+//
+// ======================================================================
+
+#include "cetlib/includer.h"
+#include "fhiclcpp/fwd.h"
+
+#include <string>
+
+namespace fhicl::detail {
+
+  // As the Boost.Spirit grammar: returns false if a construct was left
+  // incomplete.  In either case, stop is set to where parsing stopped;
+  // the document was parsed entirely only if it is s.end().
+  bool rd_parse_document(cet::includer const& s,
+                         intermediate_table& tbl,
+                         cet::includer::const_iterator& stop);
+
+  // Unlike the grammar, which throws upon an incomplete construct,
+  // returns false with unparsed set to the text from where it was
+  // detected.
+  bool rd_parse_value_string(std::string const& s,
+                             extended_value& v,
+                             std::string& unparsed);
+
+}
+
+#endif /* fhiclcpp_detail_recursive_descent_parser_h */
+
+// Local Variables:
+// mode: c++
+// End:
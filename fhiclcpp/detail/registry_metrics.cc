@@ -0,0 +1,172 @@
+#include "fhiclcpp/detail/registry_metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+using fhicl::detail::latency_histogram;
+using fhicl::detail::registry_metrics;
+using fhicl::detail::registry_op;
+
+namespace {
+  constexpr auto relaxed = std::memory_order_relaxed;
+
+  char const*
+  name(registry_op const op)
+  {
+    switch (op) {
+    case registry_op::get:
+      return "get";
+    case registry_op::put:
+      return "put";
+    case registry_op::find:
+      return "find (locked lookup)";
+    case registry_op::stage_in:
+      return "stageIn";
+    case registry_op::import:
+      return "import";
+    case registry_op::export_to:
+      return "export";
+    case registry_op::n_ops:
+      break;
+    }
+    return "?";
+  }
+
+  void
+  print_row(std::ostream& os, char const* label, latency_histogram const& h)
+  {
+    auto const n = h.count();
+    os << "  " << std::left << std::setw(22) << label << std::right
+       << std::setw(12) << n << std::setw(14) << std::fixed
+       << std::setprecision(3) << h.total_ns() / 1e6 << std::setw(12)
+       << (n ? h.total_ns() / n : 0) << std::setw(12) << h.quantile_ns(0.5)
+       << std::setw(12) << h.quantile_ns(0.99) << '\n';
+  }
+}
+
+void
+latency_histogram::record(std::chrono::nanoseconds const latency) noexcept
+{
+  auto const ns = static_cast<std::uint64_t>(
+    latency.count() > 0 ? latency.count() : 0);
+  std::size_t i = ns == 0 ? 0 : std::bit_width(ns) - 1;
+  if (i >= nbuckets) {
+    i = nbuckets - 1;
+  }
+  buckets_[i].fetch_add(1, relaxed);
+  count_.fetch_add(1, relaxed);
+  total_.fetch_add(ns, relaxed);
+}
+
+void
+latency_histogram::reset() noexcept
+{
+  for (auto& bucket : buckets_) {
+    bucket.store(0, relaxed);
+  }
+  count_.store(0, relaxed);
+  total_.store(0, relaxed);
+}
+
+std::uint64_t
+latency_histogram::count() const noexcept
+{
+  return count_.load(relaxed);
+}
+
+std::uint64_t
+latency_histogram::total_ns() const noexcept
+{
+  return total_.load(relaxed);
+}
+
+std::uint64_t
+latency_histogram::bucket(std::size_t const i) const noexcept
+{
+  return buckets_[i].load(relaxed);
+}
+
+std::uint64_t
+latency_histogram::quantile_ns(double const q) const noexcept
+{
+  std::uint64_t total{};
+  for (auto const& bucket : buckets_) {
+    total += bucket.load(relaxed);
+  }
+  if (total == 0) {
+    return 0;
+  }
+  // The smallest rank with at least q of the samples at or below it.
+  auto const rank = std::max<std::uint64_t>(
+    1, static_cast<std::uint64_t>(std::ceil(q * total)));
+  std::uint64_t seen{};
+  for (std::size_t i = 0; i != nbuckets; ++i) {
+    seen += buckets_[i].load(relaxed);
+    if (seen >= rank) {
+      return std::uint64_t{2} << i;
+    }
+  }
+  return std::uint64_t{2} << (nbuckets - 1);
+}
+
+registry_metrics&
+registry_metrics::instance() noexcept
+{
+  static registry_metrics s_metrics;
+  return s_metrics;
+}
+
+latency_histogram&
+registry_metrics::operator[](registry_op const op) noexcept
+{
+  return latency[static_cast<std::size_t>(op)];
+}
+
+latency_histogram const&
+registry_metrics::operator[](registry_op const op) const noexcept
+{
+  return latency[static_cast<std::size_t>(op)];
+}
+
+void
+registry_metrics::print(std::ostream& os) const
+{
+  if constexpr (!registry_metrics_enabled) {
+    os << "ParameterSetRegistry metrics are not enabled (build with "
+          "FHICLCPP_REGISTRY_METRICS).\n";
+    return;
+  }
+  auto const flags = os.flags();
+  auto const precision = os.precision();
+  os << "ParameterSetRegistry metrics:\n"
+     << "  " << std::left << std::setw(22) << "operation" << std::right
+     << std::setw(12) << "calls" << std::setw(14) << "total ms"
+     << std::setw(12) << "mean ns" << std::setw(12) << "p50 ns <"
+     << std::setw(12) << "p99 ns <" << '\n';
+  for (std::size_t i = 0; i != latency.size(); ++i) {
+    print_row(os, name(static_cast<registry_op>(i)), latency[i]);
+  }
+  print_row(os, "lock wait", lock_wait);
+  print_row(os, "lock hold", lock_hold);
+  os << "  DB fallbacks: " << db_fallbacks.load(relaxed)
+     << "\n  blobs parsed: " << blobs_parsed.load(relaxed) << " ("
+     << bytes_parsed.load(relaxed) << " bytes)\n";
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void
+registry_metrics::reset() noexcept
+{
+  for (auto& h : latency) {
+    h.reset();
+  }
+  lock_wait.reset();
+  lock_hold.reset();
+  db_fallbacks.store(0, relaxed);
+  blobs_parsed.store(0, relaxed);
+  bytes_parsed.store(0, relaxed);
+}
@@ -0,0 +1,187 @@
+#ifndef fhiclcpp_detail_registry_metrics_h
+#define fhiclcpp_detail_registry_metrics_h
+
+// ======================================================================
+//
+// registry_metrics: opt-in instrumentation of ParameterSetRegistry.
+//
+// Recording is compiled in only when FHICLCPP_REGISTRY_METRICS is
+// defined (see the CMake option of the same name); otherwise the
+// timers and the metered lock below reduce to nothing and a plain
+// lock, and every metric stays zero.  The metrics may be read (and
+// reset) at any time, e.g. via ParameterSetRegistry::metrics().
+//
+// Latencies are kept in histograms of power-of-two buckets of
+// nanoseconds, so quantiles are accurate to within a factor of two.
+//
+// ======================================================================
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+
+namespace fhicl::detail {
+
+#ifdef FHICLCPP_REGISTRY_METRICS
+  inline constexpr bool registry_metrics_enabled{true};
+#else
+  inline constexpr bool registry_metrics_enabled{false};
+#endif
+
+  class latency_histogram {
+  public:
+    // Bucket i holds latencies in [2^i, 2^(i+1)) ns; bucket 0 also
+    // holds 0, and the last bucket everything beyond.
+    static constexpr std::size_t nbuckets{40};
+
+    void record(std::chrono::nanoseconds latency) noexcept;
+    void reset() noexcept;
+
+    std::uint64_t count() const noexcept;
+    std::uint64_t total_ns() const noexcept;
+    std::uint64_t bucket(std::size_t i) const noexcept;
+    // The upper edge of the bucket containing quantile q (in [0, 1]),
+    // or 0 if nothing has been recorded.
+    std::uint64_t quantile_ns(double q) const noexcept;
+
+  private:
+    std::array<std::atomic<std::uint64_t>, nbuckets> buckets_{};
+    std::atomic<std::uint64_t> count_{};
+    std::atomic<std::uint64_t> total_{};
+  };
+
+  enum class registry_op : std::size_t {
+    get,
+    put,
+    find,
+    stage_in,
+    import,
+    export_to,
+    n_ops
+  };
+
+  struct registry_metrics {
+    static registry_metrics& instance() noexcept;
+
+    latency_histogram& operator[](registry_op op) noexcept;
+    latency_histogram const& operator[](registry_op op) const noexcept;
+
+    void print(std::ostream& os) const;
+    void reset() noexcept;
+
+    std::array<latency_histogram, static_cast<std::size_t>(registry_op::n_ops)>
+      latency{};
+    // Per acquisition of the registry mutex, including recursive ones.
+    latency_histogram lock_wait{};
+    latency_histogram lock_hold{};
+    // Lookups satisfied by reading the backing DB, a lazily-imported
+    // file or a mapped snapshot, and the blobs decoded to do so (or to
+    // stage them in).
+    std::atomic<std::uint64_t> db_fallbacks{};
+    std::atomic<std::uint64_t> blobs_parsed{};
+    std::atomic<std::uint64_t> bytes_parsed{};
+  };
+
+  // Records the lifetime of a registry operation.
+  class registry_timer {
+  public:
+    explicit registry_timer(registry_op const op) noexcept
+    {
+      if constexpr (registry_metrics_enabled) {
+        op_ = op;
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+    ~registry_timer() noexcept
+    {
+      if constexpr (registry_metrics_enabled) {
+        registry_metrics::instance()[op_].record(
+          std::chrono::steady_clock::now() - start_);
+      }
+    }
+    registry_timer(registry_timer const&) = delete;
+    registry_timer& operator=(registry_timer const&) = delete;
+
+  private:
+    registry_op op_{};
+    std::chrono::steady_clock::time_point start_{};
+  };
+
+  // A lock_guard (or, with std::defer_lock, a minimal unique_lock)
+  // that records how long the mutex was waited for and held.
+  template <typename Mutex>
+  class metered_lock {
+  public:
+    explicit metered_lock(Mutex& m) : mutex_{m} { lock(); }
+    metered_lock(Mutex& m, std::defer_lock_t) noexcept : mutex_{m} {}
+    ~metered_lock() noexcept
+    {
+      if (owns_) {
+        unlock();
+      }
+    }
+    metered_lock(metered_lock const&) = delete;
+    metered_lock& operator=(metered_lock const&) = delete;
+
+    void
+    lock()
+    {
+      if constexpr (registry_metrics_enabled) {
+        auto const start = std::chrono::steady_clock::now();
+        mutex_.lock();
+        acquired_ = std::chrono::steady_clock::now();
+        registry_metrics::instance().lock_wait.record(acquired_ - start);
+      } else {
+        mutex_.lock();
+      }
+      owns_ = true;
+    }
+
+    void
+    unlock() noexcept
+    {
+      if constexpr (registry_metrics_enabled) {
+        registry_metrics::instance().lock_hold.record(
+          std::chrono::steady_clock::now() - acquired_);
+      }
+      owns_ = false;
+      mutex_.unlock();
+    }
+
+  private:
+    Mutex& mutex_;
+    bool owns_{false};
+    std::chrono::steady_clock::time_point acquired_{};
+  };
+
+  // Record that a blob of the given size was decoded.
+  inline void
+  count_parsed_blob([[maybe_unused]] std::size_t const bytes) noexcept
+  {
+    if constexpr (registry_metrics_enabled) {
+      auto& metrics = registry_metrics::instance();
+      metrics.blobs_parsed.fetch_add(1, std::memory_order_relaxed);
+      metrics.bytes_parsed.fetch_add(bytes, std::memory_order_relaxed);
+    }
+  }
+
+  inline void
+  count_db_fallback() noexcept
+  {
+    if constexpr (registry_metrics_enabled) {
+      registry_metrics::instance().db_fallbacks.fetch_add(
+        1, std::memory_order_relaxed);
+    }
+  }
+
+}
+
+#endif /* fhiclcpp_detail_registry_metrics_h */
+
+// Local Variables:
+// mode: c++
+// End:
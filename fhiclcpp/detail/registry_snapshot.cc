@@ -0,0 +1,229 @@
+#include "fhiclcpp/detail/registry_snapshot.h"
+#include "fhiclcpp/exception.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using fhicl::ParameterSetID;
+using fhicl::detail::registry_snapshot;
+
+namespace {
+  // "\x7fFHS", a version byte, and three bytes of padding, then the
+  // number of entries.
+  constexpr char magic[]{"\x7f"
+                         "FHS"};
+  constexpr std::size_t magic_sz{sizeof(magic) - 1};
+  constexpr unsigned char version{1};
+  constexpr std::size_t header_sz{16};
+  constexpr std::size_t digest_sz{cet::sha1::digest_sz};
+  constexpr std::size_t entry_sz{digest_sz + 2 * sizeof(std::uint64_t)};
+
+  void
+  put_u64(std::string& out, std::uint64_t n)
+  {
+    for (std::size_t i = 0; i != sizeof(n); ++i, n >>= 8) {
+      out.push_back(static_cast<char>(n & 0xff));
+    }
+  }
+
+  std::uint64_t
+  get_u64(unsigned char const* p) noexcept
+  {
+    std::uint64_t result{};
+    for (std::size_t i = sizeof(result); i != 0; --i) {
+      result = (result << 8) | p[i - 1];
+    }
+    return result;
+  }
+
+  [[noreturn]] void
+  throw_bad_snapshot(std::string const& filename, char const* why)
+  {
+    throw fhicl::exception(fhicl::error::cant_open_db,
+                           "Invalid ParameterSet snapshot")
+      << filename << ": " << why << '\n';
+  }
+}
+
+registry_snapshot::registry_snapshot(std::string const& filename)
+  : filename_{filename}
+{
+  int const fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throw fhicl::exception(fhicl::error::cant_open_db,
+                           "Can't open ParameterSet snapshot")
+      << filename << ": " << std::strerror(errno) << '\n';
+  }
+  struct stat st;
+  void* data = MAP_FAILED;
+  if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+    bytes_ = static_cast<std::size_t>(st.st_size);
+    data = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  // The mapping outlives the descriptor.
+  int const err{errno};
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    bytes_ = 0;
+    throw fhicl::exception(fhicl::error::cant_open_db,
+                           "Can't map ParameterSet snapshot")
+      << filename << ": " << std::strerror(err) << '\n';
+  }
+  data_ = static_cast<unsigned char const*>(data);
+
+  if (bytes_ < header_sz || std::memcmp(data_, magic, magic_sz) != 0) {
+    unmap_();
+    throw_bad_snapshot(filename, "not a snapshot file");
+  }
+  if (data_[magic_sz] != version) {
+    unmap_();
+    throw_bad_snapshot(filename, "unsupported version");
+  }
+  auto const n = get_u64(data_ + 8);
+  if (n > (bytes_ - header_sz) / entry_sz) {
+    unmap_();
+    throw_bad_snapshot(filename, "truncated index");
+  }
+  size_ = static_cast<std::size_t>(n);
+}
+
+registry_snapshot::~registry_snapshot() noexcept
+{
+  unmap_();
+}
+
+registry_snapshot::registry_snapshot(registry_snapshot&& other) noexcept
+  : filename_{std::move(other.filename_)}
+  , data_{std::exchange(other.data_, nullptr)}
+  , bytes_{std::exchange(other.bytes_, 0)}
+  , size_{std::exchange(other.size_, 0)}
+{}
+
+registry_snapshot&
+registry_snapshot::operator=(registry_snapshot&& other) noexcept
+{
+  if (this != &other) {
+    unmap_();
+    filename_ = std::move(other.filename_);
+    data_ = std::exchange(other.data_, nullptr);
+    bytes_ = std::exchange(other.bytes_, 0);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+ParameterSetID
+registry_snapshot::id(std::size_t const i) const
+{
+  cet::sha1::digest_t digest;
+  std::memcpy(digest.data(), entry_(i), digest_sz);
+  return ParameterSetID{digest};
+}
+
+std::string_view
+registry_snapshot::blob(std::size_t const i) const
+{
+  auto const* entry = entry_(i);
+  auto const offset = get_u64(entry + digest_sz);
+  auto const size = get_u64(entry + digest_sz + sizeof(std::uint64_t));
+  if (offset > bytes_ || size > bytes_ - offset) {
+    throw_bad_snapshot(filename_, "entry out of bounds");
+  }
+  return {reinterpret_cast<char const*>(data_ + offset),
+          static_cast<std::size_t>(size)};
+}
+
+std::string_view
+registry_snapshot::find(ParameterSetID const& id) const
+{
+  auto const* digest = id.digest().data();
+  std::size_t lo{}, hi{size_};
+  while (lo != hi) {
+    auto const mid = lo + (hi - lo) / 2;
+    auto const cmp = std::memcmp(entry_(mid), digest, digest_sz);
+    if (cmp == 0) {
+      return blob(mid);
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return {};
+}
+
+void
+registry_snapshot::write(
+  std::string const& filename,
+  std::vector<std::pair<ParameterSetID, std::string>>& entries)
+{
+  auto const by_id = [](auto const& a, auto const& b) {
+    return a.first < b.first;
+  };
+  std::stable_sort(entries.begin(), entries.end(), by_id);
+  entries.erase(std::unique(entries.begin(),
+                            entries.end(),
+                            [](auto const& a, auto const& b) {
+                              return a.first == b.first;
+                            }),
+                entries.end());
+
+  std::string index{magic, magic_sz};
+  index.push_back(static_cast<char>(version));
+  index.append(3, '\0');
+  put_u64(index, entries.size());
+  std::uint64_t offset{header_sz + entries.size() * entry_sz};
+  for (auto const& [id, psBlob] : entries) {
+    auto const& digest = id.digest();
+    index.append(reinterpret_cast<char const*>(digest.data()), digest_sz);
+    put_u64(index, offset);
+    put_u64(index, psBlob.size());
+    offset += psBlob.size();
+  }
+
+  // Write under a private name and rename into place, so that a
+  // snapshot that is already mapped is never modified.
+  auto const tmpname = filename + ".tmp." + std::to_string(::getpid());
+  {
+    std::ofstream out{tmpname, std::ios::binary | std::ios::trunc};
+    out.write(index.data(), index.size());
+    for (auto const& entry : entries) {
+      out.write(entry.second.data(), entry.second.size());
+    }
+    out.close();
+    if (!out) {
+      std::filesystem::remove(tmpname);
+      throw fhicl::exception(fhicl::error::cant_open_db,
+                             "Can't write ParameterSet snapshot")
+        << filename << '\n';
+    }
+  }
+  std::filesystem::rename(tmpname, filename);
+}
+
+unsigned char const*
+registry_snapshot::entry_(std::size_t const i) const noexcept
+{
+  return data_ + header_sz + i * entry_sz;
+}
+
+void
+registry_snapshot::unmap_() noexcept
+{
+  if (data_ != nullptr) {
+    ::munmap(const_cast<unsigned char*>(data_), bytes_);
+    data_ = nullptr;
+  }
+  bytes_ = 0;
+  size_ = 0;
+}
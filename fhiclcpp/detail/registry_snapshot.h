@@ -0,0 +1,75 @@
+#ifndef fhiclcpp_detail_registry_snapshot_h
+#define fhiclcpp_detail_registry_snapshot_h
+
+// ======================================================================
+//
+// registry_snapshot: a read-only, memory-mapped file holding a set of
+//                    serialized ParameterSets, looked up by ID.
+//
+// The file is a header, an index of (digest, offset, size) entries
+// sorted by digest, and the serialized ParameterSets themselves
+// (normally ParameterSet::to_binary_string()).  Integers are stored
+// little-endian, so a file may be shared between hosts.
+//
+// A snapshot is written once, under a temporary name that is then
+// renamed into place, and never modified; processes mapping the same
+// file share its pages.  Views returned by find and blob remain valid
+// as long as the snapshot that returned them.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSetID.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fhicl::detail {
+
+  class registry_snapshot {
+  public:
+    explicit registry_snapshot(std::string const& filename);
+    ~registry_snapshot() noexcept;
+
+    registry_snapshot(registry_snapshot const&) = delete;
+    registry_snapshot& operator=(registry_snapshot const&) = delete;
+    registry_snapshot(registry_snapshot&& other) noexcept;
+    registry_snapshot& operator=(registry_snapshot&& other) noexcept;
+
+    std::size_t
+    size() const noexcept
+    {
+      return size_;
+    }
+
+    ParameterSetID id(std::size_t i) const;
+    std::string_view blob(std::size_t i) const;
+
+    // The blob for id, or an empty view if there is none.
+    std::string_view find(ParameterSetID const& id) const;
+
+    // Of entries with the same ID, only the first is written.  The
+    // entries are sorted in place.
+    static void write(
+      std::string const& filename,
+      std::vector<std::pair<ParameterSetID, std::string>>& entries);
+
+  private:
+    unsigned char const* entry_(std::size_t i) const noexcept;
+    void unmap_() noexcept;
+
+    std::string filename_{};
+    unsigned char const* data_{nullptr};
+    std::size_t bytes_{};
+    std::size_t size_{};
+  };
+
+}
+
+#endif /* fhiclcpp_detail_registry_snapshot_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,33 @@
+#include "fhiclcpp/detail/shared_table.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetID.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+
+#include <utility>
+
+namespace {
+  // The ID is computed before the table is shared so that later
+  // concurrent calls to id() only read it.
+  fhicl::ParameterSet&&
+  with_id(fhicl::ParameterSet&& pset)
+  {
+    (void)pset.id();
+    return std::move(pset);
+  }
+}
+
+fhicl::detail::shared_table::shared_table(ParameterSet pset)
+  : pset_{std::make_shared<ParameterSet const>(with_id(std::move(pset)))}
+{}
+
+fhicl::ParameterSetID
+fhicl::detail::shared_table::id() const
+{
+  return pset_->id();
+}
+
+fhicl::ParameterSetID
+fhicl::detail::shared_table::registered_id() const
+{
+  return ParameterSetRegistry::put(*pset_);
+}
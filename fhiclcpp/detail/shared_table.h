@@ -0,0 +1,48 @@
+#ifndef fhiclcpp_detail_shared_table_h
+#define fhiclcpp_detail_shared_table_h
+
+// ======================================================================
+//
+// shared_table: a nested table held directly by its parent, as a
+//               shared, immutable ParameterSet, rather than by
+//               ParameterSetID via the ParameterSetRegistry.
+//
+// Copies of the parent share the child.  The child is registered
+// only when its ID must be resolvable by others: when a
+// ParameterSetID is requested for it, or when it is replaced by an
+// ID reference in a compact string.  See
+// ParameterSet::set_shared_nested_tables.
+//
+// ======================================================================
+
+#include "fhiclcpp/fwd.h"
+
+#include <memory>
+
+namespace fhicl::detail {
+
+  class shared_table {
+  public:
+    explicit shared_table(ParameterSet pset);
+
+    ParameterSet const&
+    pset() const noexcept
+    {
+      return *pset_;
+    }
+
+    ParameterSetID id() const;
+    // Registers the table, if necessary, and returns its ID.
+    ParameterSetID registered_id() const;
+
+  private:
+    std::shared_ptr<ParameterSet const> pset_;
+  };
+
+}
+
+#endif /* fhiclcpp_detail_shared_table_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,70 @@
+#include "fhiclcpp/detail/sqlite_session.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+
+#include "sqlite3.h"
+
+using fhicl::detail::sqlite_session;
+using fhicl::detail::throwOnSQLiteFailure;
+
+sqlite_session::sqlite_session(sqlite3* const db) noexcept : db_{db} {}
+
+sqlite_session::~sqlite_session() noexcept
+{
+  finalize();
+}
+
+sqlite_session::sqlite_session(sqlite_session&& other) noexcept
+  : db_{std::exchange(other.db_, nullptr)}
+  , statements_{std::move(other.statements_)}
+{
+  other.statements_.clear();
+}
+
+sqlite_session&
+sqlite_session::operator=(sqlite_session&& other) noexcept
+{
+  if (this != &other) {
+    finalize();
+    db_ = std::exchange(other.db_, nullptr);
+    statements_ = std::move(other.statements_);
+    other.statements_.clear();
+  }
+  return *this;
+}
+
+void
+sqlite_session::apply(sqlite_pragmas const& pragmas)
+{
+  for (auto const& [name, value] : pragmas) {
+    auto const sql = "PRAGMA " + name + " = " + value + ';';
+    char* msg = nullptr;
+    sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &msg);
+    throwOnSQLiteFailure(db_, msg);
+  }
+}
+
+sqlite3_stmt*
+sqlite_session::statement(std::string_view const sql)
+{
+  for (auto const& [text, stmt] : statements_) {
+    if (text == sql) {
+      sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
+      return stmt;
+    }
+  }
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(db_, sql.data(), sql.size(), &stmt, nullptr);
+  throwOnSQLiteFailure(db_);
+  statements_.emplace_back(sql, stmt);
+  return stmt;
+}
+
+void
+sqlite_session::finalize() noexcept
+{
+  for (auto const& [text, stmt] : statements_) {
+    sqlite3_finalize(stmt);
+  }
+  statements_.clear();
+}
@@ -0,0 +1,64 @@
+#ifndef fhiclcpp_detail_sqlite_session_h
+#define fhiclcpp_detail_sqlite_session_h
+
+// ======================================================================
+//
+// sqlite_session: the prepared statements used with one SQLite
+//                 connection, each prepared on first use and reused
+//                 thereafter, and the pragmas applied to it.
+//
+// The connection itself is not owned; the session must be finalized
+// (or destroyed) before the connection is closed.
+//
+// ======================================================================
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace fhicl::detail {
+
+  // Pragma names and values, e.g. {{"journal_mode", "WAL"}}.
+  using sqlite_pragmas = std::vector<std::pair<std::string, std::string>>;
+
+  class sqlite_session {
+  public:
+    sqlite_session() = default;
+    explicit sqlite_session(sqlite3* db) noexcept;
+    ~sqlite_session() noexcept;
+
+    sqlite_session(sqlite_session const&) = delete;
+    sqlite_session& operator=(sqlite_session const&) = delete;
+    sqlite_session(sqlite_session&& other) noexcept;
+    sqlite_session& operator=(sqlite_session&& other) noexcept;
+
+    sqlite3*
+    db() const noexcept
+    {
+      return db_;
+    }
+
+    void apply(sqlite_pragmas const& pragmas);
+
+    // The statement for sql, reset and with no bindings.  It remains
+    // valid until the session is finalized.
+    sqlite3_stmt* statement(std::string_view sql);
+
+    void finalize() noexcept;
+
+  private:
+    sqlite3* db_{nullptr};
+    std::vector<std::pair<std::string, sqlite3_stmt*>> statements_;
+  };
+
+}
+
+#endif /* fhiclcpp_detail_sqlite_session_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,105 @@
+#include "fhiclcpp/detail/stored_value.h"
+
+#include <exception>
+#include <utility>
+
+using fhicl::detail::stored_value;
+
+fhicl::detail::stored_value::stored_value(stored_value const& other)
+  : value_{other.value_}
+{
+  copy_cache_(other);
+}
+
+fhicl::detail::stored_value::stored_value(stored_value&& other) noexcept
+  : value_{std::move(other.value_)}
+{
+  copy_cache_(other);
+}
+
+stored_value&
+fhicl::detail::stored_value::operator=(stored_value const& other)
+{
+  value_ = other.value_;
+  copy_cache_(other);
+  return *this;
+}
+
+stored_value&
+fhicl::detail::stored_value::operator=(stored_value&& other) noexcept
+{
+  value_ = std::move(other.value_);
+  copy_cache_(other);
+  return *this;
+}
+
+void
+fhicl::detail::stored_value::copy_cache_(stored_value const& other) noexcept
+{
+  // A cache that is still being filled by another thread is not
+  // copied; the copy will fill its own on demand.
+  auto const number_state = other.number_state_.load(std::memory_order_acquire);
+  if (number_state == valid || number_state == invalid) {
+    number_ = other.number_;
+    number_state_.store(number_state, std::memory_order_relaxed);
+  } else {
+    number_state_.store(unknown, std::memory_order_relaxed);
+  }
+
+  auto const bool_state = other.bool_state_.load(std::memory_order_acquire);
+  if (bool_state == valid || bool_state == invalid) {
+    boolean_ = other.boolean_;
+    bool_state_.store(bool_state, std::memory_order_relaxed);
+  } else {
+    bool_state_.store(unknown, std::memory_order_relaxed);
+  }
+}
+
+// Decode the value once, recording the outcome for later readers.  Only
+// the thread that claims the empty cache writes to it; any thread racing
+// with it simply uses its own result.
+template <class T>
+bool
+fhicl::detail::stored_value::cached_(std::atomic<unsigned char>& state,
+                                     T& cache,
+                                     T& result) const
+{
+  auto const current = state.load(std::memory_order_acquire);
+  if (current == valid) {
+    result = cache;
+    return true;
+  }
+  if (current == invalid) {
+    return false;
+  }
+
+  bool ok{true};
+  try {
+    decode(value_, result);
+  }
+  catch (std::exception const&) {
+    ok = false;
+  }
+
+  unsigned char expected{unknown};
+  if (state.compare_exchange_strong(
+        expected, computing, std::memory_order_acq_rel)) {
+    if (ok) {
+      cache = result;
+    }
+    state.store(ok ? valid : invalid, std::memory_order_release);
+  }
+  return ok;
+}
+
+bool
+fhicl::detail::stored_value::cached_number_(ldbl& result) const
+{
+  return cached_(number_state_, number_, result);
+}
+
+bool
+fhicl::detail::stored_value::cached_bool_(bool& result) const
+{
+  return cached_(bool_state_, boolean_, result);
+}
@@ -0,0 +1,127 @@
+#ifndef fhiclcpp_detail_stored_value_h
+#define fhiclcpp_detail_stored_value_h
+
+// ======================================================================
+//
+// stored_value: the value of one ParameterSet entry, together with a
+//               lazily-filled cache of its numeric or boolean
+//               interpretation.
+//
+// The canonical representation held in the std::any remains the only
+// source of truth (it alone contributes to the ParameterSetID); the
+// cache merely records the result of decoding it, the first time a
+// numeric or boolean value is requested.  Filling the cache is safe
+// with respect to concurrent reads of the same const ParameterSet.
+//
+// Only successful decodings are served from the cache.  Whenever the
+// cached interpretation is absent, or does not apply, the caller falls
+// back to the ordinary decode functions so that every diagnostic is
+// unchanged.
+//
+// ======================================================================
+
+#include "boost/numeric/conversion/cast.hpp"
+#include "fhiclcpp/coding.h"
+
+#include <any>
+#include <atomic>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace fhicl::detail {
+
+  class stored_value {
+  public:
+    stored_value() = default;
+    // Constrained so that the copy constructor of stored_value is never
+    // considered via a conversion to std::any.
+    template <class A>
+      requires std::same_as<std::remove_cvref_t<A>, std::any>
+    explicit stored_value(A&& value) : value_{std::forward<A>(value)}
+    {}
+    // Constructs the held value of type E in place from args.
+    template <class E, class... Args>
+    explicit stored_value(std::in_place_type_t<E> const type, Args&&... args)
+      : value_{type, std::forward<Args>(args)...}
+    {}
+
+    stored_value(stored_value const& other);
+    stored_value(stored_value&& other) noexcept;
+    stored_value& operator=(stored_value const& other);
+    stored_value& operator=(stored_value&& other) noexcept;
+
+    std::any const&
+    value() const noexcept
+    {
+      return value_;
+    }
+
+    // Returns false if the result must be obtained via detail::decode.
+    template <class T>
+    bool decode_cached(T& result) const;
+
+  private:
+    enum state : unsigned char { unknown, computing, valid, invalid };
+
+    template <class T>
+    bool cached_(std::atomic<unsigned char>& state,
+                 T& cache,
+                 T& result) const;
+    bool cached_number_(ldbl& result) const;
+    bool cached_bool_(bool& result) const;
+    void copy_cache_(stored_value const& other) noexcept;
+
+    std::any value_;
+    mutable std::atomic<unsigned char> number_state_{unknown};
+    mutable std::atomic<unsigned char> bool_state_{unknown};
+    mutable bool boolean_{};
+    mutable ldbl number_{};
+  };
+
+}
+
+// ======================================================================
+
+template <class T>
+bool
+fhicl::detail::stored_value::decode_cached(T& result) const
+{
+  // Each branch mirrors the corresponding decode overload (see
+  // coding.h and coding.cc), starting from the decoded long double.
+  if constexpr (std::same_as<T, bool>) {
+    return cached_bool_(result);
+  } else if constexpr (std::floating_point<T>) {
+    ldbl via;
+    if (!cached_number_(via)) {
+      return false;
+    }
+    result = via;
+    return true;
+  } else if constexpr (std::unsigned_integral<T> || std::signed_integral<T>) {
+    using via_t = std::
+      conditional_t<std::signed_integral<T>, std::intmax_t, std::uintmax_t>;
+    ldbl number;
+    // Infinities are not integers; leave the diagnostic to decode.
+    if (!cached_number_(number) || std::isinf(number)) {
+      return false;
+    }
+    auto const via = boost::numeric_cast<via_t>(number);
+    if (number != ldbl(via)) {
+      throw std::range_error("narrowing conversion");
+    }
+    result = boost::numeric_cast<T>(via);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+#endif /* fhiclcpp_detail_stored_value_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,35 @@
+#include "fhiclcpp/detail/table_ref.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+
+#include <utility>
+
+fhicl::detail::table_ref::~table_ref() noexcept
+{
+  release_();
+}
+
+fhicl::detail::table_ref::table_ref(table_ref&& other) noexcept
+  : pset_{std::exchange(other.pset_, nullptr)}
+  , pinned_{std::exchange(other.pinned_, std::nullopt)}
+{}
+
+auto
+fhicl::detail::table_ref::operator=(table_ref&& other) noexcept -> table_ref&
+{
+  if (this != &other) {
+    release_();
+    pset_ = std::exchange(other.pset_, nullptr);
+    pinned_ = std::exchange(other.pinned_, std::nullopt);
+  }
+  return *this;
+}
+
+void
+fhicl::detail::table_ref::release_() noexcept
+{
+  if (pinned_) {
+    ParameterSetRegistry::unpin(*pinned_);
+    pinned_.reset();
+  }
+  pset_ = nullptr;
+}
@@ -0,0 +1,70 @@
+#ifndef fhiclcpp_detail_table_ref_h
+#define fhiclcpp_detail_table_ref_h
+
+// ======================================================================
+//
+// table_ref: a reference to a nested table (see detail::get_table)
+//            that keeps the table in memory while the reference
+//            exists.
+//
+// Once the ParameterSetRegistry has a memory budget, a registered
+// table may be evicted by any registration, on any thread.  Such a
+// table is pinned (see ParameterSetRegistry::pin) for the lifetime of
+// the table_ref that refers to it.  Tables that are never evicted --
+// those held directly by their parents, and those registered while the
+// registry was unbounded -- are not pinned.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSetID.h"
+#include "fhiclcpp/fwd.h"
+
+#include <optional>
+
+namespace fhicl::detail {
+
+  class table_ref {
+  public:
+    table_ref() = default; // Refers to nothing.
+    explicit table_ref(ParameterSet const& pset) noexcept : pset_{&pset} {}
+    // Takes over a pin already held on id, the ID of pset.
+    table_ref(ParameterSet const& pset, ParameterSetID const& id) noexcept
+      : pset_{&pset}, pinned_{id}
+    {}
+    ~table_ref() noexcept;
+
+    table_ref(table_ref const&) = delete;
+    table_ref& operator=(table_ref const&) = delete;
+    table_ref(table_ref&& other) noexcept;
+    table_ref& operator=(table_ref&& other) noexcept;
+
+    explicit
+    operator bool() const noexcept
+    {
+      return pset_ != nullptr;
+    }
+    ParameterSet const&
+    operator*() const noexcept
+    {
+      return *pset_;
+    }
+    ParameterSet const*
+    operator->() const noexcept
+    {
+      return pset_;
+    }
+
+  private:
+    void release_() noexcept;
+
+    ParameterSet const* pset_{nullptr};
+    std::optional<ParameterSetID> pinned_{};
+  };
+
+}
+
+#endif /* fhiclcpp_detail_table_ref_h */
+
+// Local Variables:
+// mode: c++
+// End:
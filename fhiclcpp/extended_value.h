@@ -46,21 +46,24 @@ public:
 
   extended_value(bool const in_prolog,
                  value_tag const tag,
-                 std::any const value,
+                 std::any value,
                  Protection const protection,
                  std::string src = {})
     : in_prolog{in_prolog}
     , tag{tag}
-    , value{value}
+    , value{std::move(value)}
     , src_info{std::move(src)}
     , protection{protection}
   {}
 
   extended_value(bool const in_prolog,
                  value_tag const tag,
-                 std::any const value,
+                 std::any value,
                  std::string src = {})
-    : in_prolog{in_prolog}, tag{tag}, value{value}, src_info{std::move(src)}
+    : in_prolog{in_prolog}
+    , tag{tag}
+    , value{std::move(value)}
+    , src_info{std::move(src)}
   {}
 
   bool
@@ -9,6 +9,7 @@
 
 namespace fhicl {
 
+  class KeyPath;
   class ParameterSet;
   class ParameterSetID;
   class ParameterSetWalker;
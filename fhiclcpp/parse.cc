@@ -13,11 +13,13 @@
 #include "boost/spirit/include/support_istream_iterator.hpp"
 #include "boost/spirit/repository/home/qi/primitive/iter_pos.hpp"
 
-#include "cetlib/canonical_number.h"
-#include "cetlib/canonical_string.h"
 #include "cetlib/include.h"
 #include "cetlib/includer.h"
 #include "fhiclcpp/detail/binding_modifier.h"
+#include "fhiclcpp/detail/memory_streambuf.h"
+#include "fhiclcpp/detail/parse_cache.h"
+#include "fhiclcpp/detail/parse_actions.h"
+#include "fhiclcpp/detail/recursive_descent_parser.h"
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/extended_value.h"
 #include "fhiclcpp/intermediate_table.h"
@@ -26,7 +28,13 @@
 
 #include <algorithm>
 #include <any>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace ascii = ::boost::spirit::ascii;
@@ -51,6 +59,13 @@ using qi::skip;
 
 using namespace fhicl;
 using fhicl::detail::binding_modifier;
+using fhicl::detail::canon_inf;
+using fhicl::detail::canon_nil;
+using fhicl::detail::canon_num;
+using fhicl::detail::canon_str;
+using fhicl::detail::map_erase;
+using fhicl::detail::map_insert;
+using fhicl::detail::seq_insert_value;
 using atom_t = extended_value::atom_t;
 using complex_t = extended_value::complex_t;
 using sequence_t = extended_value::sequence_t;
@@ -64,101 +79,6 @@ using fhicl::TABLEID;
 
 namespace {
 
-  void
-  check_element_protections(std::string const& name,
-                            Protection const p,
-                            extended_value& v)
-  {
-    using std::max;
-    if (v.protection == Protection::NONE) {
-      v.protection = p;
-    } else if (v.protection < p) {
-      throw fhicl::exception(fhicl::error::protection_violation)
-        << "Nested item " << name << " has protection "
-        << to_string(v.protection)
-        << ((!v.src_info.empty()) ?
-              (std::string(" on ") + v.pretty_src_info()) :
-              "")
-        << ", which is incompatible with an enclosing item's protection of "
-        << to_string(p) << "\n";
-    }
-
-    if (v.tag == fhicl::SEQUENCE) {
-      std::size_t count = 0;
-      for (auto& subv : sequence_t(v)) {
-        check_element_protections(
-          name + '[' + std::to_string(count) + ']', max(p, v.protection), subv);
-      }
-    } else if (v.tag == fhicl::TABLE) {
-      for (auto& [key, value] : table_t(v)) {
-        std::string sname(name);
-        if (!sname.empty()) {
-          sname.append(".");
-        }
-        sname.append(key);
-        check_element_protections(sname, max(p, v.protection), value);
-      }
-    }
-  }
-
-  void
-  check_protection(std::string const& name, extended_value& v)
-  {
-    if (v.is_a(SEQUENCE) || v.is_a(TABLE)) {
-      check_element_protections(name, v.protection, v);
-    }
-  }
-
-  void
-  set_protection(std::string const& name,
-                 binding_modifier const m,
-                 extended_value& v)
-  {
-    if (m == binding_modifier::NONE) {
-      return;
-    }
-
-    v.protection = static_cast<Protection>(m);
-    check_protection(name, v);
-  }
-
-  std::string
-  canon_nil()
-  {
-    static std::string const canon_nil(9, '\0');
-    return canon_nil;
-  }
-
-  std::string
-  canon_inf(std::string const& inf)
-  {
-    return inf[0] == 'i' ? ('+' + inf) : inf;
-  }
-
-  std::string
-  canon_num(std::string const& num)
-  {
-    std::string result;
-    return cet::canonical_number(num, result) ?
-             result :
-             throw fhicl::exception(fhicl::error::parse_error)
-               << "The string '" << num
-               << "' is not representable as a canonical number.";
-  }
-
-  std::string
-  canon_str(std::string const& str)
-  {
-    std::string result;
-    return cet::canonical_string(str, result) ?
-             result :
-             throw fhicl::exception(fhicl::error::parse_error)
-               << "The string " + str +
-                    " is not representable as a canonical string.\n"
-               << "It is likely you have an unescaped (or incorrectly escaped) "
-                  "character.";
-  }
-
   extended_value
   xvalue_vp(bool const b, value_tag const t, std::any const v)
   {
@@ -173,92 +93,6 @@ namespace {
     return std::make_pair(c1, c2);
   }
 
-  void
-  map_insert(std::string const& name,
-             binding_modifier const m,
-             extended_value& value,
-             table_t& t)
-  {
-    set_protection(name, m, value);
-    auto const i = t.find(name);
-    if (i != t.end()) {
-      auto existing_protection = i->second.protection;
-      if (value.protection > existing_protection) {
-        throw fhicl::exception(fhicl::error::protection_violation)
-          << "Inserting name " << name << " would increase protection from "
-          << to_string(existing_protection) << " to "
-          << to_string(value.protection) << "\n(previous definition on "
-          << i->second.pretty_src_info() << ")\n";
-      }
-      switch (i->second.protection) {
-      case Protection::NONE:
-        break;
-      case Protection::PROTECT_IGNORE:
-        // Do not overwrite protected binding.
-        return;
-      case Protection::PROTECT_ERROR:
-        throw fhicl::exception(fhicl::error::protection_violation)
-          << '"' << name << "\" is protected on " << i->second.pretty_src_info()
-          << '\n';
-      }
-    }
-    t[name] = value;
-  }
-
-  void
-  map_insert_loc(std::string const& name,
-                 binding_modifier const m,
-                 extended_value& value,
-                 table_t& t,
-                 iter_t const pos,
-                 cet::includer const& s)
-  try {
-    map_insert(name, m, value, t);
-  }
-  catch (fhicl::exception& e) {
-    throw fhicl::exception(fhicl::error::parse_error, "Error in assignment:", e)
-      << " at " << s.highlighted_whereis(pos) << '\n';
-  }
-
-  void
-  seq_insert_value(extended_value xval, sequence_t& v)
-  {
-    xval.protection = Protection::NONE;
-    v.emplace_back(std::move(xval));
-  }
-
-  void
-  map_erase(std::string const& name, table_t& t)
-  {
-    auto const i = t.find(name);
-    if (i == t.end())
-      return;
-
-    switch (i->second.protection) {
-    case Protection::NONE:
-      t.erase(name);
-    case Protection::PROTECT_IGNORE:
-      return;
-    case Protection::PROTECT_ERROR:
-      throw fhicl::exception(fhicl::error::protection_violation)
-        << "Unable to erase " << name << " due to protection.\n";
-    }
-  }
-
-  void
-  map_erase_loc(std::string const& name,
-                table_t& t,
-                iter_t const pos,
-                cet::includer const& s)
-  try {
-    map_erase(name, t);
-  }
-  catch (fhicl::exception& e) {
-    throw fhicl::exception(
-      fhicl::error::parse_error, "Error in erase attempt:", e)
-      << " at " << s.highlighted_whereis(pos) << '\n';
-  }
-
   // ----------------------------------------------------------------------
 
   using FwdIter = std::string::const_iterator;
@@ -293,7 +127,8 @@ namespace {
   // ----------------------------------------------------------------------
 
   using Skip = qi::rule<iter_t>;
-  struct document_parser : qi::grammar<FwdIter, void(), Skip> {
+  struct document_parser : qi::grammar<FwdIter, void(), Skip>,
+                           detail::document_actions {
     using val_parser = value_parser<Skip>;
     using atom_token = val_parser::atom_token;
     using sequence_token = val_parser::sequence_token;
@@ -304,10 +139,7 @@ namespace {
     explicit document_parser(cet::includer const& s);
 
     // data members:
-    bool in_prolog{false};
-    intermediate_table tbl{};
     val_parser vp{};
-    cet::includer const& sref;
 
     // parser rules:
     atom_token name, qualname, noskip_qualname, localref, dbref;
@@ -317,154 +149,12 @@ namespace {
     nothing_token prolog, document;
 
   private:
-    extended_value
-    local_lookup(std::string const& name, iter_t const pos)
-    try {
-      extended_value result = tbl.find(name);
-      result.set_prolog(in_prolog);
-      result.set_src_info(sref.src_whereis(pos));
-      result.reset_protection();
-      return result;
-    }
-    catch (fhicl::exception const& e) {
-      throw fhicl::exception(fhicl::error::parse_error, "Local lookup error", e)
-        << "at " << sref.highlighted_whereis(pos) << "\n";
-    }
-
-    extended_value
-    database_lookup(iter_t const pos)
-    {
-      throw fhicl::exception(fhicl::error::unimplemented,
-                             "Database lookup error")
-        << "at " << sref.highlighted_whereis(pos)
-        << "\nFHiCL-cpp database lookup not yet available.\n";
-    }
-
-    void
-    insert_table_in_table(std::string const& name, table_t& t, iter_t const pos)
-    {
-      extended_value const xval = local_lookup(name, pos);
-      if (!xval.is_a(fhicl::TABLE)) {
-        throw fhicl::exception(fhicl::error::type_mismatch, "@table::")
-          << "key \"" << name << "\" does not refer to a table at "
-          << sref.highlighted_whereis(pos) << "\n";
-      }
-      auto const& incoming = std::any_cast<table_t const&>(xval.value);
-      for (auto const& [name, value] : incoming) {
-        auto& element = t[name];
-        if (!element.is_a(fhicl::UNKNOWN)) {
-          // Already exists.
-          auto const incoming_protection = value.protection;
-          if (incoming_protection > element.protection) {
-            throw fhicl::exception(fhicl::error::protection_violation)
-              << "@table::" << name << ": inserting name " << name
-              << " would increase protection from "
-              << to_string(element.protection) << " to "
-              << to_string(incoming_protection) << "\n(previous definition on "
-              << element.pretty_src_info() << ")\n";
-          }
-          switch (element.protection) {
-          case Protection::NONE:
-            break;
-          case Protection::PROTECT_IGNORE:
-            continue;
-          case Protection::PROTECT_ERROR:
-            throw fhicl::exception(fhicl::error::protection_violation)
-              << "@table::" << name << ": inserting name " << name
-              << "would violate protection on existing item"
-              << "\n(previous definition on " << element.pretty_src_info()
-              << ")\n";
-          }
-        }
-        element = value;
-        element.set_prolog(in_prolog);
-        element.set_src_info(sref.src_whereis(pos));
-      }
-    }
-
-    void
-    insert_table(std::string const& name, iter_t const pos)
-    {
-      extended_value const xval = local_lookup(name, pos);
-      if (!xval.is_a(fhicl::TABLE)) {
-        throw fhicl::exception(fhicl::error::type_mismatch, "@table::")
-          << "key \"" << name << "\" does not refer to a table at "
-          << sref.highlighted_whereis(pos) << "\n";
-      }
-      auto const& incoming = std::any_cast<table_t const&>(xval.value);
-      for (auto const& [name, value] : incoming) {
-        auto element = value;
-        element.set_prolog(in_prolog);
-        element.set_src_info(sref.src_whereis(pos));
-        tbl.insert(name, std::move(element));
-      }
-    }
-
-    void
-    seq_insert_sequence(std::string const& name,
-                        sequence_t& v,
-                        iter_t const pos)
-    {
-      extended_value const xval = local_lookup(name, pos);
-      if (!xval.is_a(fhicl::SEQUENCE)) {
-        throw fhicl::exception(fhicl::error::type_mismatch, "@sequence::")
-          << "key \"" << name << "\" does not refer to a sequence at "
-          << sref.highlighted_whereis(pos) << "\n";
-      }
-      auto const& incoming = std::any_cast<sequence_t const&>(xval.value);
-      auto it = v.insert(v.end(), incoming.cbegin(), incoming.cend());
-      for (auto const e = v.end(); it != e; ++it) {
-        using std::to_string;
-        it->protection = Protection::NONE;
-        it->set_prolog(in_prolog);
-        it->set_src_info(sref.src_whereis(pos));
-      }
-    }
-
-    extended_value
-    xvalue_(value_tag const t, std::any const v, iter_t const pos)
-    {
-      return extended_value{in_prolog, t, v, sref.src_whereis(pos)};
-    }
-
     auto
     xvalue_for(value_tag const t)
     {
       return phx::bind(&document_parser::xvalue_, this, t, qi::_2, qi::_1);
     }
 
-    void
-    tbl_erase(std::string const& name, iter_t const pos)
-    try {
-      tbl.erase(name, in_prolog);
-    }
-    catch (fhicl::exception& e) {
-      throw fhicl::exception(
-        fhicl::error::parse_error, "Error in erase attempt:", e)
-        << " at " << sref.highlighted_whereis(pos) << '\n';
-    }
-
-    void
-    tbl_insert(std::string const& name,
-               binding_modifier const m,
-               extended_value& value,
-               iter_t const pos)
-    try {
-      set_protection(name, m, value);
-      tbl.insert(name, value);
-    }
-    catch (fhicl::exception& e) {
-      throw fhicl::exception(
-        fhicl::error::parse_error, "Error in assignment:", e)
-        << " at " << sref.highlighted_whereis(pos) << '\n';
-    }
-
-    void
-    set_in_prolog(bool const value)
-    {
-      in_prolog = value;
-    }
-
   }; // document_parser
 
   // ----------------------------------------------------------------------
@@ -530,7 +220,7 @@ namespace {
   // ----------------------------------------------------------------------
 
   document_parser::document_parser(cet::includer const& s)
-    : document_parser::base_type{document}, sref{s}
+    : document_parser::base_type{document}, detail::document_actions{s}
   {
     name = fhicl::ass;
     qualname =
@@ -572,15 +262,16 @@ namespace {
                                      qi::_1)])) > lit(']');
     table =
       lit('{') >
-      *((iter_pos >> name >> fhicl::binding >> value)[phx::bind(&map_insert_loc,
-                                                                ref(qi::_2),
-                                                                qi::_3,
-                                                                ref(qi::_4),
-                                                                _val,
-                                                                qi::_1,
-                                                                sref)] |
+      *((iter_pos >> name >> fhicl::binding >>
+         value)[phx::bind(&document_parser::map_insert_loc,
+                          this,
+                          ref(qi::_2),
+                          qi::_3,
+                          ref(qi::_4),
+                          _val,
+                          qi::_1)] |
         (iter_pos >> name >> (lit(':') > lit("@erase")))[phx::bind(
-          &map_erase_loc, ref(qi::_2), _val, qi::_1, sref)] |
+          &document_parser::map_erase_loc, this, ref(qi::_2), _val, qi::_1)] |
         ((iter_pos >> lit("@table::")) >
          noskip_qualname)[phx::bind(&document_parser::insert_table_in_table,
                                     this,
@@ -654,19 +345,144 @@ namespace {
 
 // ----------------------------------------------------------------------
 
+namespace {
+  fhicl::parser_backend
+  initial_parser_backend()
+  {
+    char const* const name = std::getenv("FHICLCPP_PARSER");
+    return (name != nullptr && std::string_view{name} == "recursive_descent") ?
+             fhicl::parser_backend::recursive_descent :
+             fhicl::parser_backend::spirit;
+  }
+
+  std::atomic<fhicl::parser_backend>&
+  parser_backend_()
+  {
+    static std::atomic<fhicl::parser_backend> backend{initial_parser_backend()};
+    return backend;
+  }
+}
+
+void
+fhicl::set_parser_backend(parser_backend const backend) noexcept
+{
+  parser_backend_() = backend;
+}
+
+fhicl::parser_backend
+fhicl::active_parser_backend() noexcept
+{
+  return parser_backend_();
+}
+
+// ----------------------------------------------------------------------
+
+namespace {
+
+  bool
+  is_identifier(std::string const& s)
+  {
+    auto const ident = [](char const c) {
+      return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    };
+    return !s.empty() && !std::isdigit(static_cast<unsigned char>(s[0])) &&
+           std::all_of(s.begin(), s.end(), ident);
+  }
+
+  bool
+  is_plain_quoted(std::string const& s)
+  {
+    // The quoted tokens accept only ASCII characters.
+    if (s.size() < 2 || s[0] != s.back() ||
+        !std::all_of(s.begin(), s.end(), [](char const c) {
+          return static_cast<unsigned char>(c) < 0x80;
+        })) {
+      return false;
+    }
+    if (s[0] == '\'') {
+      return s.find('\'', 1) == s.size() - 1;
+    }
+    if (s[0] != '"') {
+      return false;
+    }
+    // As the dquoted token: \" does not terminate the string.
+    std::size_t i = 1;
+    while (i != s.size() && s[i] != '"') {
+      i += (s[i] == '\\' && i + 1 != s.size() && s[i + 1] == '"') ? 2 : 1;
+    }
+    return i == s.size() - 1;
+  }
+
+  // Values consisting of exactly one of the most common atoms --
+  // identifiers, plainly quoted strings, booleans and unsigned integers
+  // -- are recognized directly; their atoms are canonicalized as by the
+  // grammar.  Returns false for anything else, e.g. if surrounded by
+  // whitespace.
+  bool
+  parse_simple_value(std::string const& s, extended_value& result)
+  {
+    if (s == "true" || s == "false") {
+      result = xvalue_vp(false, BOOL, s);
+      return true;
+    }
+    if (!s.empty() && std::all_of(s.begin(), s.end(), [](char const c) {
+          return std::isdigit(static_cast<unsigned char>(c));
+        })) {
+      auto const first = std::min(s.find_first_not_of('0'), s.size() - 1);
+      result = xvalue_vp(false, NUMBER, canon_num(s.substr(first)));
+      return true;
+    }
+    // Identifiers that could be read as numbers are left to the grammar.
+    if ((is_identifier(s) && s != "infinity" &&
+         s.find_first_not_of("eE") != std::string::npos) ||
+        is_plain_quoted(s)) {
+      result = xvalue_vp(false, STRING, canon_str(s));
+      return true;
+    }
+    return false;
+  }
+
+  using ws_t = qi::rule<FwdIter>;
+
+  // The value grammar is immutable once built, so it is built only
+  // once per thread rather than for each value string.
+  struct value_string_parser {
+    value_string_parser()
+    {
+      whitespace = space | lit('#') >> *(char_ - eol) >> eol |
+                   lit("//") >> *(char_ - eol) >> eol;
+    }
+
+    ws_t whitespace;
+    value_parser<ws_t> value;
+  };
+
+  value_string_parser const&
+  cached_value_string_parser()
+  {
+    static thread_local value_string_parser const p;
+    return p;
+  }
+}
+
 bool
 fhicl::parse_value_string(std::string const& s,
                           extended_value& result,
                           std::string& unparsed)
 {
-  using ws_t = qi::rule<FwdIter>;
-  ws_t whitespace = space | lit('#') >> *(char_ - eol) >> eol |
-                    lit("//") >> *(char_ - eol) >> eol;
-  value_parser<ws_t> p;
+  if (parse_simple_value(s, result)) {
+    unparsed.clear();
+    return true;
+  }
+  if (active_parser_backend() == parser_backend::recursive_descent) {
+    return detail::rd_parse_value_string(s, result, unparsed);
+  }
+  auto const& p = cached_value_string_parser();
   auto begin = s.begin();
   auto const end = s.end();
   bool const b =
-    qi::phrase_parse(begin, end, p >> *whitespace, whitespace, result) &&
+    qi::phrase_parse(
+      begin, end, p.value >> *p.whitespace, p.whitespace, result) &&
     begin == end;
   unparsed = std::string(begin, end);
   return b;
@@ -678,21 +494,27 @@ namespace {
   intermediate_table
   parse_document_(cet::includer s)
   {
-    qi::rule<iter_t> whitespace = space | lit('#') >> *(char_ - eol) >> eol |
-                                  lit("//") >> *(char_ - eol) >> eol;
-    document_parser p(s);
+    intermediate_table tbl;
     auto begin = s.begin();
     auto const end = s.end();
     bool b = false;
-    try {
-      b = qi::phrase_parse(begin, end, p, whitespace);
-    }
-    catch (qi::expectation_failure<iter_t> const& e) {
-      begin = e.first;
+    if (active_parser_backend() == parser_backend::recursive_descent) {
+      b = detail::rd_parse_document(s, tbl, begin);
+    } else {
+      qi::rule<iter_t> whitespace = space | lit('#') >> *(char_ - eol) >> eol |
+                                    lit("//") >> *(char_ - eol) >> eol;
+      document_parser p(s);
+      try {
+        b = qi::phrase_parse(begin, end, p, whitespace);
+      }
+      catch (qi::expectation_failure<iter_t> const& e) {
+        begin = e.first;
+      }
+      tbl = std::move(p.tbl);
     }
     std::string const unparsed(begin, end);
     if (b && unparsed.empty()) {
-      return std::move(p.tbl);
+      return tbl;
     }
 
     auto e = fhicl::exception(fhicl::parse_error, "detected at or near")
@@ -705,10 +527,60 @@ namespace {
   }
 }
 
+namespace {
+  std::mutex parse_cache_mutex;
+  std::shared_ptr<fhicl::detail::parse_cache> active_parse_cache;
+
+  std::shared_ptr<fhicl::detail::parse_cache>
+  current_parse_cache()
+  {
+    std::lock_guard const lock{parse_cache_mutex};
+    return active_parse_cache;
+  }
+}
+
+void
+fhicl::enable_parse_cache(std::size_t const max_documents,
+                          std::string const& directory)
+{
+  auto cache = std::make_shared<detail::parse_cache>(max_documents, directory);
+  std::lock_guard const lock{parse_cache_mutex};
+  active_parse_cache = std::move(cache);
+}
+
+void
+fhicl::disable_parse_cache()
+{
+  std::lock_guard const lock{parse_cache_mutex};
+  active_parse_cache.reset();
+}
+
+fhicl::parse_cache_statistics
+fhicl::parse_cache_stats()
+{
+  auto const cache = current_parse_cache();
+  return cache ? parse_cache_statistics{cache->hits(), cache->misses()} :
+                 parse_cache_statistics{};
+}
+
 fhicl::intermediate_table
 fhicl::parse_document(std::string const& filename, cet::filepath_maker& maker)
 {
-  return parse_document_(cet::includer{filename, maker});
+  auto const cache = current_parse_cache();
+  if (!cache) {
+    return parse_document_(cet::includer{filename, maker});
+  }
+  auto lookup = cache->lookup(filename, maker);
+  if (lookup.table) {
+    return std::move(*lookup.table);
+  }
+  // Names already resolved by the lookup are not resolved again.
+  detail::replaying_maker replay{lookup.resolutions, maker};
+  auto tbl = parse_document_(cet::includer{filename, replay});
+  if (replay.replayed_exactly()) {
+    cache->store(lookup, tbl);
+  }
+  return tbl;
 }
 
 fhicl::intermediate_table
@@ -720,7 +592,9 @@ fhicl::parse_document(std::istream& is, cet::filepath_maker& maker)
 fhicl::intermediate_table
 fhicl::parse_document(std::string const& s)
 {
-  std::istringstream is{s};
+  // The includer reads the document in place; it is not copied first.
+  detail::memory_streambuf buf{s};
+  std::istream is{&buf};
   cet::filepath_maker m;
   return parse_document(is, m);
 }
@@ -10,11 +10,39 @@
 #include "cetlib/filepath_maker.h"
 #include "fhiclcpp/fwd.h"
 
+#include <cstddef>
 #include <istream>
 #include <string>
 
 namespace fhicl {
 
+  // The implementation of the functions below: the Boost.Spirit
+  // grammar, or a hand-written recursive-descent parser accepting the
+  // same language and producing the same results in a single pass.
+  // The default, spirit, may be overridden by setting the
+  // FHICLCPP_PARSER environment variable to "recursive_descent".
+  enum class parser_backend { spirit, recursive_descent };
+
+  void set_parser_backend(parser_backend backend) noexcept;
+  parser_backend active_parser_backend() noexcept;
+
+  // Once enabled, parse_document(filename, maker) reuses its earlier
+  // result for a document none of whose files -- the file itself and
+  // those it #includes, as resolved by maker -- has changed since, as
+  // determined by modification time, size and contents.  At most
+  // max_documents results are held in memory; given a directory,
+  // results are also kept there as files, for use by later processes.
+  // Disabling the cache discards the results held in memory.
+  void enable_parse_cache(std::size_t max_documents = 64,
+                          std::string const& directory = {});
+  void disable_parse_cache();
+
+  struct parse_cache_statistics {
+    std::size_t hits;
+    std::size_t misses;
+  };
+  parse_cache_statistics parse_cache_stats();
+
   bool parse_value_string(std::string const& s,
                           extended_value& v,
                           std::string& unparsed);
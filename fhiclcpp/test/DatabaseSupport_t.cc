@@ -55,4 +55,26 @@ BOOST_AUTO_TEST_CASE(nested_vector)
   BOOST_TEST(records.size() == 3ul);
 }
 
+BOOST_AUTO_TEST_CASE(repeated_tables)
+{
+  fhicl::ParameterSet inner;
+  inner.put("x", 1);
+  fhicl::ParameterSet top;
+  top.put("a", inner);
+  top.put("b", inner);
+  top.put("c", std::vector<fhicl::ParameterSet>(3, inner));
+
+  std::vector<std::string> records;
+  std::vector<std::string> hashes;
+  fhicl::decompose_parameterset(top, records, hashes);
+  BOOST_TEST(records.size() == hashes.size());
+  BOOST_TEST(records.size() == 2ul);
+  BOOST_TEST(hashes.front() == top.id().to_string());
+
+  std::size_t n{};
+  fhicl::decompose_parameterset(
+    top, [&n](std::string const&, std::string const&) { ++n; });
+  BOOST_TEST(n == 2ul);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
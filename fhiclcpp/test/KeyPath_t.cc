@@ -0,0 +1,87 @@
+#define BOOST_TEST_MODULE (KeyPath test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/KeyPath.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+using namespace std::string_literals;
+
+namespace {
+  auto const pset = ParameterSet::make(R"(
+    a: 1
+    b: { c: [ 1, [ 2, 3 ] ] d: { e: "hello" } }
+    s: [ { x: 4 }, { x: 5 y: [ 6 ] } ]
+  )");
+}
+
+BOOST_AUTO_TEST_SUITE(KeyPath_t)
+
+BOOST_AUTO_TEST_CASE(parsing)
+{
+  KeyPath const key{"s[1].y[0]"};
+  BOOST_TEST(key.to_string() == "s[1].y[0]");
+  BOOST_TEST_REQUIRE(key.tables().size() == 1ull);
+  BOOST_TEST(key.tables()[0].name() == "s");
+  BOOST_TEST(key.tables()[0].indices() == std::vector<std::size_t>{1});
+  BOOST_TEST(key.last().name() == "y");
+  BOOST_TEST(key.last().indices() == std::vector<std::size_t>{0});
+  BOOST_TEST(key.last_key() == "y[0]");
+
+  BOOST_CHECK_THROW(KeyPath{""}, fhicl::exception);
+  BOOST_CHECK_THROW(KeyPath{"..."}, fhicl::exception);
+  BOOST_CHECK_THROW(KeyPath{"a[x]"}, fhicl::exception);
+}
+
+BOOST_AUTO_TEST_CASE(same_as_string_keys)
+{
+  for (auto const& key : {"a"s,
+                          "b.c[0]"s,
+                          "b.c[1][1]"s,
+                          "b.d.e"s,
+                          "s[0].x"s,
+                          "s[1].y[0]"s}) {
+    KeyPath const path{key};
+    BOOST_TEST(pset.has_key(path) == pset.has_key(key));
+    BOOST_TEST(pset.is_key_to_atom(path) == pset.is_key_to_atom(key));
+    BOOST_TEST(pset.is_key_to_sequence(path) == pset.is_key_to_sequence(key));
+    BOOST_TEST(pset.is_key_to_table(path) == pset.is_key_to_table(key));
+    BOOST_TEST(pset.get<std::string>(path) == pset.get<std::string>(key));
+  }
+  BOOST_TEST(pset.get<ParameterSet>(KeyPath{"b.d"}) ==
+             pset.get<ParameterSet>("b.d"));
+  BOOST_TEST(pset.get<std::vector<int>>(KeyPath{"b.c[1]"}) ==
+             (std::vector<int>{2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(missing_keys)
+{
+  for (auto const& key : {"z"s, "a.z"s, "b.z"s, "s[2].x"s}) {
+    KeyPath const path{key};
+    BOOST_TEST(!pset.has_key(path));
+    BOOST_TEST(!pset.get_if_present<int>(path));
+    BOOST_TEST(pset.get<int>(path, 7) == 7);
+    BOOST_CHECK_THROW(pset.get<int>(path), fhicl::exception);
+  }
+  BOOST_CHECK_THROW(pset.is_key_to_atom(KeyPath{"b.z"}), fhicl::exception);
+
+  // As for std::string keys, an out-of-range index into an existing
+  // sequence is an error rather than an absent parameter.
+  BOOST_TEST(!pset.has_key(KeyPath{"b.c[2]"}));
+  BOOST_CHECK_THROW(pset.get_if_present<int>(KeyPath{"b.c[2]"}),
+                    fhicl::exception);
+}
+
+BOOST_AUTO_TEST_CASE(type_mismatch)
+{
+  BOOST_CHECK_EXCEPTION(
+    pset.get<int>(KeyPath{"b.d.e"}), fhicl::exception, [](auto const& e) {
+      return e.categoryCode() == fhicl::error::type_mismatch;
+    });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+// ======================================================================
+//
+// Check the textual form and the hash of ParameterSetID, and that the
+// ID is the SHA-1 digest of the canonical string.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (ParameterSetID test)
+
+#include "boost/test/unit_test.hpp"
+#include "cetlib/sha1.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetID.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  // The ID as it has always been defined: the digest of the C string
+  // of the canonical form.
+  std::string
+  reference_id(ParameterSet const& ps)
+  {
+    auto const canonical = ps.to_string();
+    cet::sha1 sha{canonical.c_str()};
+    std::string result;
+    for (unsigned const byte : sha.digest()) {
+      char buf[3];
+      std::snprintf(buf, sizeof buf, "%02x", byte);
+      result += buf;
+    }
+    return result;
+  }
+
+  void
+  check_digest(ParameterSet const& ps)
+  {
+    BOOST_TEST(ParameterSetID{ps}.to_string() == reference_id(ps));
+  }
+
+  ParameterSet
+  nested(int const depth)
+  {
+    ParameterSet result;
+    result.put("depth", depth);
+    result.put("seq", std::vector<int>{1, 2, depth});
+    result.put("nil", "@nil");
+    if (depth > 0) {
+      auto const child = nested(depth - 1);
+      result.put("child", child);
+      result.put("children", std::vector<ParameterSet>{child, {}, child});
+    }
+    return result;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(ParameterSetID_test)
+
+BOOST_AUTO_TEST_CASE(to_string_test)
+{
+  // SHA-1 digest of the (empty) canonical string of an empty table.
+  BOOST_TEST(ParameterSet{}.id().to_string() ==
+             "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+  BOOST_TEST(ParameterSetID{}.to_string() == std::string(40, '0'));
+}
+
+BOOST_AUTO_TEST_CASE(round_trip_test)
+{
+  for (int i = 0; i != 100; ++i) {
+    ParameterSet ps;
+    ps.put("i", i);
+    auto const id = ps.id();
+    auto const str = id.to_string();
+    BOOST_TEST(str.size() == ParameterSetID::max_str_size());
+    BOOST_TEST(str.find_first_not_of("0123456789abcdef") == std::string::npos);
+    ParameterSetID const copy{str};
+    BOOST_TEST(copy == id);
+    BOOST_TEST(copy.hash() == id.hash());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(hash_test)
+{
+  std::set<std::size_t> hashes;
+  for (int i = 0; i != 1000; ++i) {
+    ParameterSet ps;
+    ps.put("i", i);
+    hashes.insert(ps.id().hash());
+  }
+  BOOST_TEST(hashes.size() == 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(digest_test)
+{
+  check_digest(ParameterSet{});
+  check_digest(ParameterSet::make("a: [] b: {} c: [{}, [], @nil] d: \"x y\""));
+  for (bool const shared : {false, true}) {
+    ParameterSet::set_shared_nested_tables(shared);
+    check_digest(nested(6));
+    check_digest(ParameterSet::make("outer: { inner: { x: 1 y: [a, b] } }"));
+  }
+  ParameterSet::set_shared_nested_tables(false);
+}
+
+BOOST_AUTO_TEST_CASE(embedded_nul_test)
+{
+  // Everything after a NUL character has never contributed to the ID.
+  ParameterSet ps;
+  ps.put("a", std::string("x\0y", 3));
+  ps.put("b", 1);
+  check_digest(ps);
+
+  ParameterSet other;
+  other.put("a", std::string("x\0z", 3));
+  other.put("b", 2);
+  BOOST_TEST(ps.id() == other.id());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -241,4 +241,159 @@ BOOST_AUTO_TEST_CASE(TestExport)
   sqlite3_close(db);
 }
 
+BOOST_AUTO_TEST_CASE(TestExportContents)
+{
+  // Nested tables registered only while serializing their parents must
+  // be exported, too.
+  ParameterSet::set_shared_nested_tables(true);
+  auto const pset = ParameterSet::make(
+    "outer: { inner: { s: \"Long enough to be replaced by an ID.\" x: 1 } }");
+  ParameterSet::set_shared_nested_tables(false);
+  ParameterSetRegistry::put(pset);
+  auto const expected_size = ParameterSetRegistry::size() + 2;
+
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  ParameterSetRegistry::exportTo(db);
+  BOOST_TEST_REQUIRE(ParameterSetRegistry::size() == expected_size);
+
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(
+    db, "SELECT ID, PSetBlob FROM ParameterSets;", -1, &stmt, nullptr);
+  size_t rows{};
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    ++rows;
+    string const id{
+      reinterpret_cast<char const*>(sqlite3_column_text(stmt, 0))};
+    string const blob{
+      reinterpret_cast<char const*>(sqlite3_column_text(stmt, 1))};
+    auto const& registered = ParameterSetRegistry::get(ParameterSetID{id});
+    BOOST_TEST(blob == registered.to_compact_string());
+    BOOST_TEST(registered.id().to_string() == id);
+    // Stored with the terminating NUL.
+    BOOST_TEST(sqlite3_column_bytes(stmt, 1) == int(blob.size() + 1));
+  }
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+  BOOST_TEST(rows == expected_size);
+}
+
+BOOST_AUTO_TEST_CASE(TestStageIn)
+{
+  // Enough ParameterSets that stageIn parses them on several threads.
+  vector<ParameterSet> psets;
+  for (int i = 0; i != 1000; ++i) {
+    ParameterSet ps;
+    ps.put("stage_in", i);
+    ps.put("label", "staged"s + to_string(i));
+    psets.push_back(ps);
+  }
+  // One of them is already registered.
+  ParameterSetRegistry::put(psets.front());
+
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  sqlite3_exec(db,
+               "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+               nullptr,
+               nullptr,
+               nullptr);
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(db,
+                     "INSERT INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);",
+                     -1,
+                     &stmt,
+                     nullptr);
+  for (auto const& ps : psets) {
+    auto const id = ps.id().to_string();
+    auto const blob = ps.to_compact_string();
+    sqlite3_bind_text(stmt, 1, id.c_str(), id.size() + 1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, blob.c_str(), blob.size() + 1, SQLITE_STATIC);
+    BOOST_TEST_REQUIRE(sqlite3_step(stmt) == SQLITE_DONE);
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+  ParameterSetRegistry::importFrom(db);
+  sqlite3_close(db);
+
+  auto const expected_size = ParameterSetRegistry::size() + psets.size() - 1;
+  ParameterSetRegistry::stageIn();
+  BOOST_TEST(ParameterSetRegistry::size() == expected_size);
+  for (auto const& ps : psets) {
+    auto const& registered = ParameterSetRegistry::get().at(ps.id());
+    BOOST_TEST(registered == ps);
+  }
+  // Staging in again changes nothing.
+  ParameterSetRegistry::stageIn();
+  BOOST_TEST(ParameterSetRegistry::size() == expected_size);
+}
+
+BOOST_AUTO_TEST_CASE(TestExportPragmas)
+{
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  ParameterSetRegistry::exportTo(
+    db, {{"cache_size", "-4096"}, {"synchronous", "OFF"}});
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(db, "PRAGMA cache_size;", -1, &stmt, nullptr);
+  BOOST_TEST_REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+  BOOST_TEST(sqlite3_column_int(stmt, 0) == -4096);
+  sqlite3_finalize(stmt);
+  sqlite3_prepare_v2(
+    db, "SELECT COUNT(*) from ParameterSets;", -1, &stmt, nullptr);
+  BOOST_TEST_REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+  BOOST_TEST(std::size_t(sqlite3_column_int64(stmt, 0)) ==
+             ParameterSetRegistry::size());
+  sqlite3_finalize(stmt);
+  BOOST_CHECK_THROW(ParameterSetRegistry::exportTo(db, {{"no such", "1"}}),
+                    fhicl::exception);
+  sqlite3_close(db);
+}
+
+BOOST_AUTO_TEST_CASE(BatchedRegistration)
+{
+  auto const size = ParameterSetRegistry::size();
+  ParameterSet a;
+  a.put("x", 1);
+  ParameterSet b;
+  b.put("y", 2);
+  {
+    detail::registration_batch batch;
+    auto const idA = ParameterSetRegistry::put(a);
+    {
+      // A nested batch defers to the outermost one.
+      detail::registration_batch inner;
+      ParameterSetRegistry::put(b);
+      inner.commit();
+    }
+    // Pending ParameterSets are visible to this thread only.
+    BOOST_TEST(ParameterSetRegistry::has(idA));
+    BOOST_TEST(ParameterSetRegistry::get(b.id()) == b);
+    BOOST_TEST(ParameterSetRegistry::size() == size);
+    batch.commit();
+  }
+  BOOST_TEST(ParameterSetRegistry::size() == size + 2);
+  BOOST_TEST(ParameterSetRegistry::get(a.id()) == a);
+
+  ParameterSet c;
+  c.put("z", 3);
+  {
+    detail::registration_batch batch;
+    ParameterSetRegistry::put(c);
+  }
+  // Not committed, so discarded.
+  BOOST_TEST(!ParameterSetRegistry::has(c.id()));
+  BOOST_TEST(ParameterSetRegistry::size() == size + 2);
+
+  // Building a ParameterSet registers all of its nested tables.
+  auto const ps = ParameterSet::make(
+    "outer: { inner: { deep: { v: 1 } } list: [ { w: 2 }, { w: 3 } ] }"s);
+  BOOST_TEST(ParameterSetRegistry::size() == size + 7);
+  ParameterSet const outer = ps.get<ParameterSet>("outer");
+  BOOST_TEST(ParameterSetRegistry::has(outer.id()));
+  BOOST_TEST(ParameterSetRegistry::get(outer.id()) == outer);
+  BOOST_TEST(ParameterSetRegistry::get(outer.id())
+               .get<int>("inner.deep.v") == 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
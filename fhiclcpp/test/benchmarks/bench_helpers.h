@@ -0,0 +1,57 @@
+#ifndef fhiclcpp_test_benchmarks_bench_helpers_h
+#define fhiclcpp_test_benchmarks_bench_helpers_h
+
+// ======================================================================
+//
+// bench_helpers: minimal timing support shared by the fhiclcpp
+//                micro-benchmarks.
+//
+// ======================================================================
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+
+namespace fhicl::bench {
+
+  // Number of repetitions, optionally overridden by the first
+  // command-line argument.
+  inline std::size_t
+  repetitions(int argc, char** argv, std::size_t const default_reps)
+  {
+    if (argc > 1) {
+      return std::stoul(argv[1]);
+    }
+    return default_reps;
+  }
+
+  // Average wall-clock time per call of f, in nanoseconds.
+  template <typename F>
+  double
+  ns_per_op(std::size_t const reps, F f)
+  {
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    for (std::size_t i = 0; i != reps; ++i) {
+      f();
+    }
+    auto const stop = steady_clock::now();
+    return duration<double, std::nano>(stop - start).count() /
+           (reps ? reps : 1);
+  }
+
+  // Prevent the optimizer from discarding a benchmarked result.
+  template <typename T>
+  void
+  do_not_optimize(T const& value)
+  {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+}
+
+#endif /* fhiclcpp_test_benchmarks_bench_helpers_h */
+
+// Local Variables:
+// mode: c++
+// End:
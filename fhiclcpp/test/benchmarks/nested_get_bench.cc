@@ -0,0 +1,85 @@
+// ======================================================================
+//
+// nested_get_bench: cost of ParameterSet::get<T> for dotted keys as a
+//                   function of nesting depth and table width, for
+//                   both std::string and pre-parsed fhicl::KeyPath keys,
+//                   and with nested tables held by ID (via the
+//                   registry) or shared directly by their parents.
+//
+// Usage: nested_get_bench [repetitions]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace fhicl;
+
+namespace {
+
+  // Each level holds 'width' atoms in addition to the table leading
+  // to the next level; the innermost table holds the 'value' atom.
+  ParameterSet
+  make_nested(std::size_t const depth, std::size_t const width)
+  {
+    ParameterSet result;
+    result.put("value", 42);
+    for (std::size_t level = depth; level != 0; --level) {
+      for (std::size_t i = 0; i != width; ++i) {
+        result.put("p" + std::to_string(i), static_cast<int>(i));
+      }
+      ParameterSet parent;
+      parent.put("t" + std::to_string(level - 1), result);
+      result = std::move(parent);
+    }
+    return result;
+  }
+
+  std::string
+  nested_key(std::size_t const depth)
+  {
+    std::string result;
+    for (std::size_t level = 0; level != depth; ++level) {
+      result.append("t").append(std::to_string(level)).append(".");
+    }
+    return result.append("value");
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const reps = bench::repetitions(argc, argv, 20000);
+
+  std::cout << std::setw(8) << "depth" << std::setw(8) << "width"
+            << std::setw(16) << "ns/get<int>" << std::setw(16) << "ns (KeyPath)"
+            << std::setw(16) << "ns (shared)" << '\n';
+  for (std::size_t const depth : {0u, 1u, 2u, 4u, 8u}) {
+    for (std::size_t const width : {1u, 10u, 100u, 1000u}) {
+      auto const pset = make_nested(depth, width);
+      auto const key = nested_key(depth);
+      KeyPath const path{key};
+      auto const ns = bench::ns_per_op(
+        reps, [&pset, &key] { bench::do_not_optimize(pset.get<int>(key)); });
+      auto const ns_path = bench::ns_per_op(
+        reps, [&pset, &path] { bench::do_not_optimize(pset.get<int>(path)); });
+
+      ParameterSet::set_shared_nested_tables(true);
+      auto const shared = make_nested(depth, width);
+      ParameterSet::set_shared_nested_tables(false);
+      auto const ns_shared = bench::ns_per_op(reps, [&shared, &key] {
+        bench::do_not_optimize(shared.get<int>(key));
+      });
+
+      std::cout << std::setw(8) << depth << std::setw(8) << width
+                << std::fixed << std::setprecision(1) << std::setw(16) << ns
+                << std::setw(16) << ns_path << std::setw(16) << ns_shared
+                << '\n';
+    }
+  }
+}
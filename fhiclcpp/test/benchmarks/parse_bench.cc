@@ -0,0 +1,131 @@
+// ======================================================================
+//
+// parse_bench: parse_document throughput of each parser backend, and
+//              with the parse cache, in MB/s of document text.
+//
+// Usage: parse_bench [repetitions [file.fcl...]]
+//
+// Files are looked up via FHICL_FILE_PATH and may #include others;
+// only the text of the named file itself is counted.  Without files, a
+// synthetic art-like configuration of a few hundred modules is parsed.
+// Each file is also parsed with the parse cache enabled.
+//
+// ======================================================================
+
+#include "cetlib/filepath_maker.h"
+#include "fhiclcpp/intermediate_table.h"
+#include "fhiclcpp/parse.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace fhicl;
+
+namespace {
+
+  std::string
+  synthetic_document(std::size_t const modules)
+  {
+    std::ostringstream os;
+    os << "BEGIN_PROLOG\n"
+       << "# Shared defaults.\n"
+       << "standard_producer: {\n"
+       << "  module_type: StandardProducer\n"
+       << "  verbosity: 0\n"
+       << "  thresholds: [ 0.5, 1.5e-3, -2.25, 0x1F ]\n"
+       << "  calibration: { gain: 1.02 offset: -0.3 channels: [1, 2, 3, 4] }\n"
+       << "}\n"
+       << "END_PROLOG\n\n"
+       << "process_name: BENCH\n"
+       << "services: { message: { destinations: { log: { type: cout "
+          "threshold: \"INFO\" } } } }\n"
+       << "physics: {\n  producers: {\n";
+    for (std::size_t i = 0; i != modules; ++i) {
+      os << "    p" << i << ": {\n"
+         << "      @table::standard_producer\n"
+         << "      label: \"producer_" << i << "\"\n"
+         << "      index: " << i << "\n"
+         << "      weights: [ " << i << ".5, " << i << "e-2, (1, " << i
+         << ") ]\n"
+         << "      enabled: " << (i % 2 ? "true" : "false") << "  // toggled\n"
+         << "      inputs: [ 'p" << (i ? i - 1 : 0) << "', 'raw' ]\n"
+         << "    }\n";
+    }
+    os << "  }\n  path: [";
+    for (std::size_t i = 0; i != modules; ++i) {
+      os << (i ? ", p" : " p") << i;
+    }
+    os << " ]\n  trigger_paths: [ path ]\n}\n"
+       << "physics.producers.p0.verbosity: 2\n";
+    return os.str();
+  }
+
+  std::string
+  read_file(std::string const& filename)
+  {
+    std::ifstream in{filename};
+    std::ostringstream os;
+    os << in.rdbuf();
+    return os.str();
+  }
+
+  template <typename F>
+  void
+  report_line(char const* label,
+              std::size_t const bytes,
+              std::size_t const reps,
+              F f)
+  {
+    f(); // Warm up.
+    auto const ns = bench::ns_per_op(reps, f);
+    std::cout << "  " << std::left << std::setw(20) << label << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10)
+              << ns / 1e3 << " us  " << std::setw(8) << bytes / ns * 1e3
+              << " MB/s\n";
+  }
+
+  void
+  report(std::string const& filename,
+         cet::filepath_maker& maker,
+         std::size_t const reps)
+  {
+    auto const bytes = read_file(maker(filename)).size();
+    auto const parse = [&filename, &maker] {
+      bench::do_not_optimize(parse_document(filename, maker).empty());
+    };
+    std::cout << filename << " (" << bytes << " bytes)\n";
+    set_parser_backend(parser_backend::spirit);
+    report_line("spirit", bytes, reps, parse);
+    set_parser_backend(parser_backend::recursive_descent);
+    report_line("recursive_descent", bytes, reps, parse);
+    enable_parse_cache();
+    report_line("cached", bytes, reps, parse);
+    disable_parse_cache();
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const reps = bench::repetitions(argc, argv, 20);
+  if (argc > 2) {
+    cet::filepath_lookup_nonabsolute policy{"FHICL_FILE_PATH"};
+    for (int i = 2; i != argc; ++i) {
+      report(argv[i], policy, reps);
+    }
+    return 0;
+  }
+
+  auto const path =
+    std::filesystem::temp_directory_path() / "parse_bench_synthetic.fcl";
+  std::ofstream{path} << synthetic_document(500);
+  cet::filepath_maker maker;
+  report(path.string(), maker, reps);
+  std::filesystem::remove(path);
+}
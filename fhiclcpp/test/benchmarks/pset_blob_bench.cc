@@ -0,0 +1,80 @@
+// ======================================================================
+//
+// pset_blob_bench: cost of reading a ParameterSet back from the text
+//                  of to_compact_string() and from the bytes of
+//                  to_binary_string(), as the ParameterSetRegistry
+//                  does for each blob it loads.
+//
+// Usage: pset_blob_bench [repetitions]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  // A module configuration of the usual shape: atoms of every kind,
+  // numeric sequences and a few nested tables.
+  ParameterSet
+  module(std::size_t const i)
+  {
+    ParameterSet inner;
+    inner.put("threshold", 0.25 * i);
+    inner.put("enabled", i % 2 == 0);
+    inner.put("channels", std::vector<int>{1, 2, 3, 5, 8, 13, 21});
+    ParameterSet result;
+    result.put("module_type", "Producer" + std::to_string(i));
+    result.put("module_label", "module" + std::to_string(i));
+    result.put("weights", std::vector<double>(20, 1.5 * i));
+    result.put("names", std::vector<std::string>{"alpha", "beta", "gamma"});
+    result.put("selection", inner);
+    result.put("calibration", inner);
+    return result;
+  }
+
+  void
+  measure(char const* label, ParameterSet const& ps, std::size_t const reps)
+  {
+    ParameterSetRegistry::put(ps);
+    auto const text = ps.to_compact_string();
+    auto const bytes = ps.to_binary_string();
+    auto const text_ns = bench::ns_per_op(
+      reps, [&text] { bench::do_not_optimize(ParameterSet::make(text)); });
+    auto const binary_ns = bench::ns_per_op(reps, [&bytes] {
+      bench::do_not_optimize(ParameterSet::make_from_binary(bytes));
+    });
+    std::cout << std::setw(10) << label << std::setw(10) << text.size()
+              << std::setw(10) << bytes.size() << std::fixed
+              << std::setprecision(0) << std::setw(12) << text_ns
+              << std::setw(12) << binary_ns << std::setprecision(1)
+              << std::setw(10) << text_ns / binary_ns << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const reps = bench::repetitions(argc, argv, 2000);
+
+  ParameterSet paths;
+  for (std::size_t i = 0; i != 50; ++i) {
+    paths.put("module" + std::to_string(i), module(i));
+  }
+
+  std::cout << std::setw(10) << "pset" << std::setw(10) << "text B"
+            << std::setw(10) << "binary B" << std::setw(12) << "text ns"
+            << std::setw(12) << "binary ns" << std::setw(10) << "speedup"
+            << '\n';
+  measure("module", module(7), reps);
+  measure("paths", paths, reps / 10 + 1);
+}
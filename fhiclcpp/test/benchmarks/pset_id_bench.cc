@@ -0,0 +1,75 @@
+// ======================================================================
+//
+// pset_id_bench: cost of computing the ParameterSetID of wide and of
+//                deeply-nested ParameterSets, compared with that of
+//                producing their canonical strings.
+//
+// Usage: pset_id_bench [repetitions]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  ParameterSet
+  wide(std::size_t const n)
+  {
+    ParameterSet result;
+    for (std::size_t i = 0; i != n; ++i) {
+      auto const key = "parameter_" + std::to_string(i);
+      result.put(key, std::vector<double>{1.5, 2.5, double(i)});
+    }
+    return result;
+  }
+
+  ParameterSet
+  nested(std::size_t const depth)
+  {
+    auto result = wide(10);
+    if (depth > 0) {
+      result.put("child", nested(depth - 1));
+    }
+    return result;
+  }
+
+  void
+  measure(char const* label, ParameterSet const& ps, std::size_t const reps)
+  {
+    auto const size = ps.to_string().size();
+    auto const id_ns = bench::ns_per_op(reps, [&ps] {
+      bench::do_not_optimize(ParameterSetID{ps});
+    });
+    auto const string_ns = bench::ns_per_op(reps, [&ps] {
+      bench::do_not_optimize(ps.to_string().size());
+    });
+    std::cout << std::setw(12) << label << std::setw(10) << size
+              << std::fixed << std::setprecision(0) << std::setw(14)
+              << id_ns << std::setw(14) << string_ns << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const reps = bench::repetitions(argc, argv, 2000);
+
+  std::cout << std::setw(12) << "pset" << std::setw(10) << "bytes"
+            << std::setw(14) << "id ns" << std::setw(14) << "to_string ns"
+            << '\n';
+  for (std::size_t const n : {10u, 100u, 1000u}) {
+    measure(("wide " + std::to_string(n)).c_str(), wide(n), reps);
+  }
+  for (std::size_t const depth : {4u, 16u, 64u}) {
+    measure(("depth " + std::to_string(depth)).c_str(), nested(depth), reps);
+  }
+}
@@ -0,0 +1,142 @@
+// ======================================================================
+//
+// pset_storage_bench: lookup, insertion and iteration costs of the
+//                     candidate ParameterSet backing stores
+//                     (std::map and fhicl::detail::flat_map), followed
+//                     by the same operations through the ParameterSet
+//                     interface for the store selected at build time.
+//
+// Usage: pset_storage_bench [repetitions]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/detail/flat_map.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <algorithm>
+#include <any>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  // Keys resembling those of a module configuration, presented in a
+  // fixed pseudo-random order.
+  std::vector<std::string>
+  make_keys(std::size_t const n)
+  {
+    std::vector<std::string> result;
+    for (std::size_t i = 0; i != n; ++i) {
+      result.push_back("parameter_" + std::to_string(i * 7919 % 100003));
+    }
+    std::shuffle(result.begin(), result.end(), std::mt19937{42});
+    return result;
+  }
+
+  template <typename Map>
+  Map
+  fill(std::vector<std::string> const& keys)
+  {
+    Map result;
+    for (auto const& key : keys) {
+      result.emplace(key, std::any{key});
+    }
+    return result;
+  }
+
+  template <typename Map>
+  void
+  measure(char const* label,
+          std::vector<std::string> const& keys,
+          std::size_t const reps)
+  {
+    auto sorted_keys = keys;
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    auto const map = fill<Map>(keys);
+    auto const n = keys.size();
+
+    auto const insert_ns = bench::ns_per_op(reps / n + 1, [&keys] {
+      bench::do_not_optimize(fill<Map>(keys).size());
+    });
+    auto const insert_sorted_ns =
+      bench::ns_per_op(reps / n + 1, [&sorted_keys] {
+        bench::do_not_optimize(fill<Map>(sorted_keys).size());
+      });
+    std::size_t i{};
+    auto const find_ns = bench::ns_per_op(reps, [&map, &keys, &i, n] {
+      bench::do_not_optimize(map.find(keys[i++ % n]));
+    });
+    auto const iterate_ns = bench::ns_per_op(reps / n + 1, [&map] {
+      std::size_t total{};
+      for (auto const& [key, value] : map) {
+        total += key.size();
+      }
+      bench::do_not_optimize(total);
+    });
+
+    std::cout << std::setw(10) << label << std::setw(8) << n << std::fixed
+              << std::setprecision(1) << std::setw(14) << find_ns
+              << std::setw(14) << insert_ns / n << std::setw(14)
+              << insert_sorted_ns / n << std::setw(14) << iterate_ns / n
+              << '\n';
+  }
+
+  void
+  measure_pset(std::vector<std::string> const& keys, std::size_t const reps)
+  {
+    auto const n = keys.size();
+    auto fill_pset = [&keys] {
+      ParameterSet result;
+      for (auto const& key : keys) {
+        result.put(key, 1);
+      }
+      return result;
+    };
+    auto const pset = fill_pset();
+
+    auto const insert_ns = bench::ns_per_op(reps / n + 1, [&fill_pset] {
+      bench::do_not_optimize(fill_pset().is_empty());
+    });
+    std::size_t i{};
+    auto const find_ns = bench::ns_per_op(reps, [&pset, &keys, &i, n] {
+      bench::do_not_optimize(pset.has_key(keys[i++ % n]));
+    });
+    auto const iterate_ns = bench::ns_per_op(reps / n + 1, [&pset] {
+      bench::do_not_optimize(pset.get_names().size());
+    });
+
+    std::cout << std::setw(10) << "PSet" << std::setw(8) << n << std::fixed
+              << std::setprecision(1) << std::setw(14) << find_ns
+              << std::setw(14) << insert_ns / n << std::setw(14) << "-"
+              << std::setw(14) << iterate_ns / n << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const reps = bench::repetitions(argc, argv, 1000000);
+
+  using std_map = std::map<std::string, std::any>;
+  using flat_map = detail::flat_map<std::string, std::any>;
+
+  std::cout << "All times in ns per element.\n"
+            << std::setw(10) << "store" << std::setw(8) << "size"
+            << std::setw(14) << "find" << std::setw(14) << "insert"
+            << std::setw(14) << "insert sorted" << std::setw(14)
+            << "iterate" << '\n';
+  for (std::size_t const n : {10u, 100u, 1000u, 10000u}) {
+    auto const keys = make_keys(n);
+    measure<std_map>("std::map", keys, reps);
+    measure<flat_map>("flat_map", keys, reps);
+    measure_pset(keys, reps);
+  }
+}
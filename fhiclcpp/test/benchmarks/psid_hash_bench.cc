@@ -0,0 +1,64 @@
+// ======================================================================
+//
+// psid_hash_bench: cost of hashing and formatting ParameterSetIDs, and
+//                  of the registry lookups that depend on the hash.
+//
+// Usage: psid_hash_bench [repetitions]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetID.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace fhicl;
+
+int
+main(int argc, char** argv)
+{
+  auto const reps = bench::repetitions(argc, argv, 1000000);
+
+  std::vector<ParameterSetID> ids;
+  std::unordered_map<ParameterSetID, int, detail::HashParameterSetID> map;
+  for (int i = 0; i != 1000; ++i) {
+    ParameterSet pset;
+    pset.put("index", i);
+    pset.put("label", "module" + std::to_string(i));
+    ids.push_back(ParameterSetRegistry::put(pset));
+    map.emplace(ids.back(), i);
+  }
+  auto const n = ids.size();
+
+  auto report = [](char const* label, double const ns) {
+    std::cout << std::setw(28) << label << std::fixed << std::setprecision(1)
+              << std::setw(12) << ns << '\n';
+  };
+
+  std::cout << std::setw(28) << "operation" << std::setw(12) << "ns/op"
+            << '\n';
+  detail::HashParameterSetID const hash;
+  std::size_t i{};
+  report("hash", bench::ns_per_op(reps, [&] {
+           bench::do_not_optimize(hash(ids[i++ % n]));
+         }));
+  report("to_string", bench::ns_per_op(reps, [&] {
+           bench::do_not_optimize(ids[i++ % n].to_string());
+         }));
+  report("unordered_map::find", bench::ns_per_op(reps, [&] {
+           bench::do_not_optimize(map.find(ids[i++ % n]));
+         }));
+  report("ParameterSetRegistry::has", bench::ns_per_op(reps, [&] {
+           bench::do_not_optimize(ParameterSetRegistry::has(ids[i++ % n]));
+         }));
+  report("ParameterSetRegistry::get", bench::ns_per_op(reps, [&] {
+           bench::do_not_optimize(&ParameterSetRegistry::get(ids[i++ % n]));
+         }));
+}
@@ -0,0 +1,100 @@
+// ======================================================================
+//
+// registry_db_bench: throughput of ParameterSetRegistry::exportTo
+//                    writing to a temporary SQLite file, with SQLite's
+//                    default settings and with pragmas suited to bulk
+//                    writes, and of ParameterSetRegistry::importFrom
+//                    reading the result back, many times over.
+//
+// Usage: registry_db_bench [number of ParameterSets]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include "sqlite3.h"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+namespace fs = std::filesystem;
+
+namespace {
+
+  template <typename F>
+  double
+  seconds(F f)
+  {
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    f();
+    return duration<double>(steady_clock::now() - start).count();
+  }
+
+  double
+  export_to(fs::path const& path, detail::sqlite_pragmas const& pragmas)
+  {
+    fs::remove(path);
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    auto const result =
+      seconds([db, &pragmas] { ParameterSetRegistry::exportTo(db, pragmas); });
+    sqlite3_close(db);
+    return result;
+  }
+
+  double
+  import_from(fs::path const& path, std::size_t const times)
+  {
+    return seconds([&path, times] {
+      for (std::size_t i = 0; i != times; ++i) {
+        sqlite3* db = nullptr;
+        sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+        ParameterSetRegistry::importFrom(db);
+        sqlite3_close(db);
+      }
+    });
+  }
+
+  void
+  report(char const* label, std::size_t const rows, double const seconds)
+  {
+    std::cout << std::setw(24) << label << std::fixed << std::setprecision(3)
+              << std::setw(12) << seconds << std::setprecision(0)
+              << std::setw(16) << rows / seconds << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const n = bench::repetitions(argc, argv, 100000);
+  for (std::size_t i = 0; i != n; ++i) {
+    ParameterSet pset;
+    pset.put("module_type", "Producer" + std::to_string(i % 97));
+    pset.put("module_label", "module" + std::to_string(i));
+    pset.put("weights", std::vector<double>{0.5, 1.5, double(i)});
+    ParameterSetRegistry::put(pset);
+  }
+
+  auto const path = fs::temp_directory_path() / "registry_db_bench.db";
+  detail::sqlite_pragmas const bulk{{"journal_mode", "MEMORY"},
+                                    {"synchronous", "OFF"},
+                                    {"cache_size", "-65536"}};
+  std::size_t const imports{10};
+
+  std::cout << std::setw(24) << "operation" << std::setw(12) << "seconds"
+            << std::setw(16) << "rows/s" << '\n';
+  report("export, defaults", n, export_to(path, {}));
+  report("export, bulk pragmas", n, export_to(path, bulk));
+  report("import", n * imports, import_from(path, imports));
+  fs::remove(path);
+}
@@ -0,0 +1,67 @@
+// ======================================================================
+//
+// registry_export_bench: time taken by ParameterSetRegistry::exportTo
+//                        to write N synthetic ParameterSets to a
+//                        temporary SQLite file.
+//
+// Usage: registry_export_bench [number of ParameterSets]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include "sqlite3.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+int
+main(int argc, char** argv)
+{
+  auto const n = bench::repetitions(argc, argv, 100000);
+
+  for (std::size_t i = 0; i != n; ++i) {
+    ParameterSet inner;
+    inner.put("index", i);
+    inner.put("weights", std::vector<double>{0.5, 1.5, double(i)});
+    ParameterSet pset;
+    pset.put("module_type", "Producer" + std::to_string(i % 97));
+    pset.put("module_label", "module" + std::to_string(i));
+    pset.put("settings", inner);
+    ParameterSetRegistry::put(pset);
+  }
+
+  auto const path =
+    std::filesystem::temp_directory_path() / "registry_export_bench.db";
+  double best{-1.};
+  for (int trial = 0; trial != 3; ++trial) {
+    std::filesystem::remove(path);
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    ParameterSetRegistry::exportTo(db);
+    auto const elapsed =
+      duration<double>(steady_clock::now() - start).count();
+    sqlite3_close(db);
+    best = best < 0. ? elapsed : std::min(best, elapsed);
+  }
+  std::filesystem::remove(path);
+
+  auto const entries = ParameterSetRegistry::size();
+  std::cout << std::setw(12) << "entries" << std::setw(12) << "seconds"
+            << std::setw(16) << "entries/s" << '\n'
+            << std::setw(12) << entries << std::fixed << std::setprecision(3)
+            << std::setw(12) << best << std::setprecision(0) << std::setw(16)
+            << entries / best << '\n';
+}
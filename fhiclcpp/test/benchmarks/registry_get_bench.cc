@@ -0,0 +1,77 @@
+// ======================================================================
+//
+// registry_get_bench: throughput of concurrent
+//                     ParameterSetRegistry::get(ParameterSetID) calls
+//                     for already-registered ParameterSets, as a
+//                     function of the number of threads.
+//
+// Usage: registry_get_bench [lookups per thread] [maximum threads]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fhicl;
+
+int
+main(int argc, char** argv)
+{
+  auto const lookups = bench::repetitions(argc, argv, 200000);
+
+  std::vector<ParameterSetID> ids;
+  for (int i = 0; i != 1000; ++i) {
+    ParameterSet pset;
+    pset.put("index", i);
+    pset.put("label", "module" + std::to_string(i));
+    ids.push_back(ParameterSetRegistry::put(pset));
+  }
+
+  std::size_t const max_threads =
+    argc > 2 ? std::stoul(argv[2]) :
+               std::max(std::thread::hardware_concurrency(), 1u);
+  std::vector<std::size_t> thread_counts;
+  for (std::size_t n = 1; n < max_threads; n *= 2) {
+    thread_counts.push_back(n);
+  }
+  thread_counts.push_back(max_threads);
+
+  std::cout << std::setw(10) << "threads" << std::setw(18) << "Mlookups/s"
+            << std::setw(18) << "ns/lookup/thread" << '\n';
+  for (auto const n : thread_counts) {
+    auto work = [&ids, lookups](std::size_t const seed) {
+      auto const sz = ids.size();
+      for (std::size_t i = 0; i != lookups; ++i) {
+        auto const& id = ids[(seed + i * 7) % sz];
+        bench::do_not_optimize(&ParameterSetRegistry::get(id));
+      }
+    };
+
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t != n; ++t) {
+      threads.emplace_back(work, t * 131);
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    auto const elapsed =
+      duration<double, std::nano>(steady_clock::now() - start).count();
+
+    auto const total = static_cast<double>(n * lookups);
+    std::cout << std::setw(10) << n << std::fixed << std::setprecision(2)
+              << std::setw(18) << total / elapsed * 1e3 << std::setw(18)
+              << elapsed / lookups << '\n';
+  }
+}
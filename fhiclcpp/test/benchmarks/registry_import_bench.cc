@@ -0,0 +1,133 @@
+// ======================================================================
+//
+// registry_import_bench: time taken to import many ParameterSet
+//                        database files with
+//                        ParameterSetRegistry::importFrom and with
+//                        ParameterSetRegistry::importLazilyFrom, and
+//                        then to look up a few of the imported sets.
+//
+// Usage: registry_import_bench [files] [ParameterSets per file]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+
+#include "sqlite3.h"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+namespace fs = std::filesystem;
+
+namespace {
+
+  // Writes a file of n ParameterSets, distinct for each tag, and
+  // returns the ID of one of them.
+  ParameterSetID
+  write_db(fs::path const& path, std::string const& tag, std::size_t const n)
+  {
+    fs::remove(path);
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    sqlite3_exec(db,
+                 "BEGIN; CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+                 nullptr,
+                 nullptr,
+                 nullptr);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db,
+                       "INSERT INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);",
+                       -1,
+                       &stmt,
+                       nullptr);
+    ParameterSetID result;
+    for (std::size_t i = 0; i != n; ++i) {
+      ParameterSet ps;
+      ps.put("tag", tag);
+      ps.put("index", i);
+      ps.put("weights", std::vector<double>(20, double(i)));
+      auto const id = ps.id().to_string();
+      auto const blob = ps.to_compact_string();
+      sqlite3_bind_text(stmt, 1, id.c_str(), id.size() + 1, SQLITE_STATIC);
+      sqlite3_bind_text(
+        stmt, 2, blob.c_str(), blob.size() + 1, SQLITE_STATIC);
+      sqlite3_step(stmt);
+      sqlite3_reset(stmt);
+      result = ps.id();
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+    return result;
+  }
+
+  template <typename Import>
+  void
+  measure(char const* label,
+          std::vector<fs::path> const& paths,
+          std::vector<ParameterSetID> const& ids,
+          Import import)
+  {
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    for (auto const& path : paths) {
+      sqlite3* db = nullptr;
+      sqlite3_open(path.c_str(), &db);
+      import(db);
+      sqlite3_close(db);
+    }
+    auto const imported = steady_clock::now();
+    for (auto const& id : ids) {
+      ParameterSetRegistry::get(id);
+    }
+    auto const looked_up = steady_clock::now();
+    std::cout << std::setw(18) << label << std::fixed << std::setprecision(3)
+              << std::setw(14) << duration<double>(imported - start).count()
+              << std::setw(14)
+              << duration<double>(looked_up - imported).count() << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  std::size_t const files = argc > 1 ? std::stoul(argv[1]) : 200;
+  std::size_t const per_file = argc > 2 ? std::stoul(argv[2]) : 500;
+
+  // Separate files for each mode, so that neither benefits from the
+  // other's imports.
+  std::vector<fs::path> eager_paths, lazy_paths;
+  std::vector<ParameterSetID> eager_ids, lazy_ids;
+  auto const dir = fs::temp_directory_path();
+  for (std::size_t i = 0; i != files; ++i) {
+    auto const n = std::to_string(i);
+    eager_paths.push_back(dir / ("registry_import_bench_e" + n + ".db"));
+    eager_ids.push_back(write_db(eager_paths.back(), "e" + n, per_file));
+    lazy_paths.push_back(dir / ("registry_import_bench_l" + n + ".db"));
+    lazy_ids.push_back(write_db(lazy_paths.back(), "l" + n, per_file));
+  }
+
+  std::cout << files << " files of " << per_file << " ParameterSets\n"
+            << std::setw(18) << "mode" << std::setw(14) << "import s"
+            << std::setw(14) << "lookups s" << '\n';
+  measure("importFrom", eager_paths, eager_ids, [](sqlite3* db) {
+    ParameterSetRegistry::importFrom(db);
+  });
+  measure("importLazilyFrom", lazy_paths, lazy_ids, [](sqlite3* db) {
+    ParameterSetRegistry::importLazilyFrom(db);
+  });
+
+  for (auto const& path : eager_paths) {
+    fs::remove(path);
+  }
+  for (auto const& path : lazy_paths) {
+    fs::remove(path);
+  }
+}
@@ -0,0 +1,152 @@
+// ======================================================================
+//
+// registry_snapshot_bench: cold-start cost of making many
+//                          ParameterSets available from a database
+//                          file (ParameterSetRegistry::importFrom)
+//                          and from a mapped snapshot
+//                          (ParameterSetRegistry::importSnapshotFrom),
+//                          then of looking up a few of them, and then
+//                          of staging in all of them.
+//
+// Usage: registry_snapshot_bench [ParameterSets]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/detail/registry_snapshot.h"
+
+#include "sqlite3.h"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace fhicl;
+namespace fs = std::filesystem;
+
+namespace {
+
+  std::vector<ParameterSet>
+  make_psets(std::string const& tag, std::size_t const n)
+  {
+    std::vector<ParameterSet> result(n);
+    for (std::size_t i = 0; i != n; ++i) {
+      auto& ps = result[i];
+      ps.put("tag", tag);
+      ps.put("index", i);
+      ps.put("weights", std::vector<double>(20, double(i)));
+      ps.put("labels", std::vector<std::string>(5, "label"));
+    }
+    return result;
+  }
+
+  void
+  write_db(fs::path const& path, std::vector<ParameterSet> const& psets)
+  {
+    fs::remove(path);
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    sqlite3_exec(db,
+                 "BEGIN; CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+                 nullptr,
+                 nullptr,
+                 nullptr);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db,
+                       "INSERT INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);",
+                       -1,
+                       &stmt,
+                       nullptr);
+    for (auto const& ps : psets) {
+      auto const id = ps.id().to_string();
+      auto const blob = ps.to_compact_string();
+      sqlite3_bind_text(stmt, 1, id.c_str(), id.size() + 1, SQLITE_STATIC);
+      sqlite3_bind_text(
+        stmt, 2, blob.c_str(), blob.size() + 1, SQLITE_STATIC);
+      sqlite3_step(stmt);
+      sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+  }
+
+  void
+  write_snapshot(fs::path const& path, std::vector<ParameterSet> const& psets)
+  {
+    std::vector<std::pair<ParameterSetID, std::string>> entries;
+    for (auto const& ps : psets) {
+      entries.emplace_back(ps.id(), ps.to_binary_string());
+    }
+    detail::registry_snapshot::write(path.string(), entries);
+  }
+
+  void
+  measure(char const* label,
+          std::function<void()> const& import,
+          std::vector<ParameterSet> const& psets)
+  {
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    import();
+    auto const imported = steady_clock::now();
+    for (std::size_t i = 0; i < psets.size(); i += psets.size() / 10 + 1) {
+      ParameterSetRegistry::get(psets[i].id());
+    }
+    auto const looked_up = steady_clock::now();
+    ParameterSetRegistry::stageIn();
+    auto const staged_in = steady_clock::now();
+    std::cout << std::setw(20) << label << std::fixed << std::setprecision(4)
+              << std::setw(12) << duration<double>(imported - start).count()
+              << std::setw(12)
+              << duration<double>(looked_up - imported).count()
+              << std::setw(12)
+              << duration<double>(staged_in - looked_up).count() << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  std::size_t const n = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+  // Distinct ParameterSets for each mode, so that neither benefits
+  // from the other's imports.
+  auto const dir = fs::temp_directory_path();
+  auto const db_path = dir / "registry_snapshot_bench.db";
+  auto const snapshot_path = dir / "registry_snapshot_bench.snap";
+  auto const db_psets = make_psets("db", n);
+  auto const snapshot_psets = make_psets("snapshot", n);
+  write_db(db_path, db_psets);
+  write_snapshot(snapshot_path, snapshot_psets);
+
+  std::cout << n << " ParameterSets\n"
+            << std::setw(20) << "source" << std::setw(12) << "import s"
+            << std::setw(12) << "lookups s" << std::setw(12) << "stageIn s"
+            << '\n';
+  measure(
+    "importFrom",
+    [&db_path] {
+      sqlite3* db = nullptr;
+      sqlite3_open(db_path.c_str(), &db);
+      ParameterSetRegistry::importFrom(db);
+      sqlite3_close(db);
+    },
+    db_psets);
+  measure(
+    "importSnapshotFrom",
+    [&snapshot_path] {
+      ParameterSetRegistry::importSnapshotFrom(snapshot_path.string());
+    },
+    snapshot_psets);
+
+  fs::remove(db_path);
+  fs::remove(snapshot_path);
+}
@@ -0,0 +1,41 @@
+// ======================================================================
+//
+// sequence_indices_bench: cost of splitting a key into its name and
+//                         sequence indices, for representative key
+//                         shapes.
+//
+// Usage: sequence_indices_bench [repetitions]
+//
+// ======================================================================
+
+#include "fhiclcpp/detail/ParameterSetImplHelpers.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace fhicl;
+
+int
+main(int argc, char** argv)
+{
+  auto const reps = bench::repetitions(argc, argv, 200000);
+
+  std::cout << std::left << std::setw(40) << "key" << std::right
+            << std::setw(12) << "ns/split" << '\n';
+  for (std::string const key : {"x",
+                                "module_label",
+                                "a_rather_longer_parameter_name",
+                                "seq[0]",
+                                "seq[12][3]",
+                                "seq[1][2][3][4]",
+                                "a_rather_longer_parameter_name[123]"}) {
+    auto const ns = bench::ns_per_op(reps, [&key] {
+      bench::do_not_optimize(detail::get_sequence_indices(key));
+    });
+    std::cout << std::left << std::setw(40) << key << std::right
+              << std::setw(12) << std::fixed << std::setprecision(1) << ns
+              << '\n';
+  }
+}
@@ -0,0 +1,100 @@
+// ======================================================================
+//
+// stage_in_bench: time taken by ParameterSetRegistry::stageIn to parse
+//                 N synthetic ParameterSets imported from a database,
+//                 with TBB limited to 1, 2, 4, ... threads.
+//
+// Usage: stage_in_bench [number of ParameterSets]
+//
+// Everything staged in stays registered, so each thread count stages
+// in its own set of ParameterSets.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include "sqlite3.h"
+#include "tbb/global_control.h"
+#include "tbb/info.h"
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  // Imports n ParameterSets, distinct for each tag, into the backing
+  // DB of the registry.
+  void
+  import_synthetic(std::string const& tag, std::size_t const n)
+  {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    sqlite3_exec(db,
+                 "BEGIN; CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+                 nullptr,
+                 nullptr,
+                 nullptr);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db,
+                       "INSERT INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);",
+                       -1,
+                       &stmt,
+                       nullptr);
+    for (std::size_t i = 0; i != n; ++i) {
+      ParameterSet ps;
+      ps.put("module_type", "Producer" + std::to_string(i % 97));
+      ps.put("module_label", tag + "_module" + std::to_string(i));
+      ps.put("weights", std::vector<double>(20, double(i)));
+      auto const id = ps.id().to_string();
+      auto const blob = ps.to_compact_string();
+      sqlite3_bind_text(stmt, 1, id.c_str(), id.size() + 1, SQLITE_STATIC);
+      sqlite3_bind_text(
+        stmt, 2, blob.c_str(), blob.size() + 1, SQLITE_STATIC);
+      sqlite3_step(stmt);
+      sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    ParameterSetRegistry::importFrom(db);
+    sqlite3_close(db);
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const n = bench::repetitions(argc, argv, 100000);
+  int const max_threads = tbb::info::default_concurrency();
+
+  std::cout << std::setw(10) << "threads" << std::setw(12) << "seconds"
+            << std::setw(16) << "psets/s" << '\n';
+  for (int threads = 1;; threads *= 2) {
+    if (threads > max_threads) {
+      threads = max_threads;
+    }
+    import_synthetic("t" + std::to_string(threads), n);
+    tbb::global_control const limit{
+      tbb::global_control::max_allowed_parallelism,
+      static_cast<std::size_t>(threads)};
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    ParameterSetRegistry::stageIn();
+    auto const elapsed =
+      duration<double>(steady_clock::now() - start).count();
+    std::cout << std::setw(10) << threads << std::fixed
+              << std::setprecision(3) << std::setw(12) << elapsed
+              << std::setprecision(0) << std::setw(16) << n / elapsed
+              << '\n';
+    if (threads == max_threads) {
+      break;
+    }
+  }
+}
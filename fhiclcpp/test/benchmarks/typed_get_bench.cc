@@ -0,0 +1,52 @@
+// ======================================================================
+//
+// typed_get_bench: cost of repeated ParameterSet::get<T> calls for
+//                  top-level atoms of various types.  The first read of
+//                  each atom is reported separately since it fills the
+//                  typed cache.
+//
+// Usage: typed_get_bench [repetitions]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace fhicl;
+
+namespace {
+
+  template <typename T>
+  void
+  measure(char const* label, std::string const& key, std::size_t const reps)
+  {
+    auto const pset = ParameterSet::make("a: 42 b: -1.25e-3 c: true d: 'x'");
+    auto const first_ns = bench::ns_per_op(1, [&pset, &key] {
+      bench::do_not_optimize(pset.get<T>(key));
+    });
+    auto const ns = bench::ns_per_op(reps, [&pset, &key] {
+      bench::do_not_optimize(pset.get<T>(key));
+    });
+    std::cout << std::setw(14) << label << std::fixed << std::setprecision(1)
+              << std::setw(14) << first_ns << std::setw(14) << ns << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const reps = bench::repetitions(argc, argv, 100000);
+
+  std::cout << std::setw(14) << "type" << std::setw(14) << "ns (first)"
+            << std::setw(14) << "ns/get" << '\n';
+  measure<int>("int", "a", reps);
+  measure<unsigned long>("unsigned long", "a", reps);
+  measure<double>("double", "b", reps);
+  measure<bool>("bool", "c", reps);
+  measure<std::string>("std::string", "d", reps);
+}
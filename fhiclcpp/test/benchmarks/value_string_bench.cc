@@ -0,0 +1,78 @@
+// ======================================================================
+//
+// value_string_bench: cost of parse_value_string for values of various
+//                     forms, and of the programmatic ParameterSet
+//                     operations that rely upon it (putting strings,
+//                     reading a sequence stored as a string).
+//
+// Usage: value_string_bench [repetitions]
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/extended_value.h"
+#include "fhiclcpp/parse.h"
+#include "fhiclcpp/test/benchmarks/bench_helpers.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  template <typename F>
+  void
+  report(char const* label, std::size_t const reps, F f)
+  {
+    std::cout << std::setw(28) << label << std::fixed << std::setprecision(1)
+              << std::setw(14) << bench::ns_per_op(reps, f) << '\n';
+  }
+
+  void
+  measure_parse(char const* label,
+                std::string const& s,
+                std::size_t const reps)
+  {
+    report(label, reps, [&s] {
+      extended_value v;
+      std::string unparsed;
+      bench::do_not_optimize(parse_value_string(s, v, unparsed));
+    });
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const reps = bench::repetitions(argc, argv, 20000);
+
+  std::cout << std::setw(28) << "operation" << std::setw(14) << "ns/op"
+            << '\n';
+  measure_parse("parse identifier", "module_label", reps);
+  measure_parse("parse single-quoted", "'a plain string'", reps);
+  measure_parse("parse double-quoted", "\"a plain string\"", reps);
+  measure_parse("parse integer", "12345", reps);
+  measure_parse("parse real", "-1.25e-3", reps);
+  measure_parse("parse sequence", "[1, 2, 3, 4]", reps);
+
+  report("put std::string", reps, [] {
+    ParameterSet ps;
+    ps.put("label", std::string{"a plain string"});
+    bench::do_not_optimize(ps.is_empty());
+  });
+  report("put vector<std::string>", reps, [] {
+    ParameterSet ps;
+    ps.put("labels", std::vector<std::string>{"a", "b", "c", "d"});
+    bench::do_not_optimize(ps.is_empty());
+  });
+
+  ParameterSet stored;
+  stored.put("v", std::string{"[1, 2, 3, 4]"});
+  report("get vector<int> from string", reps, [&stored] {
+    bench::do_not_optimize(stored.get<std::vector<int>>("v").size());
+  });
+}
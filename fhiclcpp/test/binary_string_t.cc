@@ -0,0 +1,137 @@
+// ======================================================================
+//
+// Check that ParameterSet::to_binary_string() is read back by
+// ParameterSet::make_from_binary as the same ParameterSet, and that
+// the ParameterSetRegistry reads and writes both it and text blobs.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (binary string test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+
+#include "sqlite3.h"
+
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+using namespace std::string_literals;
+
+namespace {
+  auto const config = R"(
+    a: { b: { c: 1 d: [ 2, 3.5, -4e10 ] } e: "a string with \"quotes\"" }
+    s: [ { x: 4 }, { x: 5 y: { z: 6 } }, [], [ [ true, false ] ] ]
+    n: @nil
+    u: [ @nil, "" ]
+    t: {}
+    f: 0x7f
+  )";
+
+  ParameterSet
+  round_trip(ParameterSet const& ps)
+  {
+    auto const bytes = ps.to_binary_string();
+    BOOST_TEST(ParameterSet::is_binary(bytes));
+    return ParameterSet::make_from_binary(bytes);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(binary_string_t)
+
+BOOST_AUTO_TEST_CASE(round_trips)
+{
+  auto const pset = ParameterSet::make(config);
+  ParameterSetRegistry::put(pset);
+  auto const copy = round_trip(pset);
+  BOOST_TEST(copy == pset);
+  BOOST_TEST(copy.id() == pset.id());
+  BOOST_TEST(copy.to_string() == pset.to_string());
+  BOOST_TEST(copy.get<double>("a.b.d[1]") == 3.5);
+  BOOST_TEST(copy.get<int>("s[1].y.z") == 6);
+  BOOST_TEST(copy.get<std::string>("a.e") == "a string with \"quotes\"");
+  BOOST_TEST(copy.is_key_to_atom("n"));
+  BOOST_TEST(copy.get<ParameterSet>("t").is_empty());
+
+  BOOST_TEST(round_trip(ParameterSet{}).is_empty());
+  BOOST_TEST(!ParameterSet::is_binary(pset.to_compact_string()));
+  BOOST_TEST(!ParameterSet::is_binary(""));
+}
+
+BOOST_AUTO_TEST_CASE(shared_nested_tables)
+{
+  // Nested tables held directly are registered when written by ID.
+  // (Theirs, in turn, are registered when they are written.)
+  ParameterSet::set_shared_nested_tables(true);
+  auto const pset = ParameterSet::make("outer: { inner: { x: 42 } }");
+  ParameterSet::set_shared_nested_tables(false);
+  auto const bytes = pset.to_binary_string();
+  auto const outer_id = pset.get<ParameterSetID>("outer");
+  BOOST_TEST(ParameterSetRegistry::has(outer_id));
+  BOOST_TEST(ParameterSet::make_from_binary(bytes) == pset);
+}
+
+BOOST_AUTO_TEST_CASE(malformed)
+{
+  auto const bytes = ParameterSet::make("a: 1 b: [2, 3]").to_binary_string();
+  for (auto n = bytes.size(); n-- != 0;) {
+    BOOST_CHECK_THROW(ParameterSet::make_from_binary(bytes.substr(0, n)),
+                      fhicl::exception);
+  }
+  BOOST_CHECK_THROW(ParameterSet::make_from_binary(bytes + "x"),
+                    fhicl::exception);
+  auto future = bytes;
+  future[4] = 2; // An unknown version.
+  BOOST_CHECK_THROW(ParameterSet::make_from_binary(future), fhicl::exception);
+}
+
+BOOST_AUTO_TEST_CASE(registry_blobs)
+{
+  auto const pset = ParameterSet::make(config);
+  ParameterSetRegistry::put(pset);
+
+  BOOST_TEST_REQUIRE(!ParameterSetRegistry::binary_blobs());
+  ParameterSetRegistry::set_binary_blobs(true);
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(sqlite3_open(":memory:", &db) == SQLITE_OK);
+  ParameterSetRegistry::exportTo(db);
+  ParameterSetRegistry::set_binary_blobs(false);
+
+  // Every row is a BLOB, and is read back as the registered set.
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(
+    db, "SELECT ID, PSetBlob FROM ParameterSets;", -1, &stmt, nullptr);
+  std::size_t rows{};
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    ++rows;
+    BOOST_TEST(sqlite3_column_type(stmt, 1) == SQLITE_BLOB);
+    std::string const bytes(
+      static_cast<char const*>(sqlite3_column_blob(stmt, 1)),
+      sqlite3_column_bytes(stmt, 1));
+    ParameterSetID const id{
+      reinterpret_cast<char const*>(sqlite3_column_text(stmt, 0))};
+    BOOST_TEST(ParameterSet::make_from_binary(bytes) ==
+               ParameterSetRegistry::get(id));
+  }
+  sqlite3_finalize(stmt);
+  BOOST_TEST(rows == ParameterSetRegistry::size());
+
+  // A mixture of text and binary rows is imported, staged in and
+  // exported again unchanged.
+  auto const text = ParameterSet::make("text_only: 1");
+  auto const sql = "INSERT INTO ParameterSets(ID, PSetBlob) VALUES('" +
+                   text.id().to_string() + "', '" +
+                   text.to_compact_string() + "');";
+  BOOST_TEST_REQUIRE(
+    sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+  ParameterSetRegistry::importFrom(db);
+  sqlite3_close(db);
+  BOOST_TEST(ParameterSetRegistry::get(text.id()) == text);
+  ParameterSetRegistry::stageIn();
+  BOOST_TEST(ParameterSetRegistry::get(pset.id()) == pset);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,128 @@
+// ======================================================================
+//
+// Check that detail::encode(std::string) yields exactly what
+// canonicalizing via the value grammar does -- the same atom, or an
+// error in both cases -- for randomly generated strings.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (encode string test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/coding.h"
+#include "fhiclcpp/exception.h"
+#include "fhiclcpp/extended_value.h"
+#include "fhiclcpp/parse.h"
+
+#include <cstddef>
+#include <random>
+#include <string>
+
+using namespace fhicl;
+
+namespace {
+
+  std::string const failed{"<error>"};
+
+  // The canonicalization of a string by the value grammar.
+  std::string
+  reference_encode(std::string const& value)
+  {
+    bool const is_quoted = value.size() >= 2 && value[0] == value.back() &&
+                           (value[0] == '"' || value[0] == '\'');
+    std::string const str = is_quoted ? value : '\'' + value + '\'';
+    extended_value xval;
+    std::string unparsed;
+    // Leading whitespace keeps the value from being recognized
+    // without the grammar.
+    if (!parse_value_string(' ' + str, xval, unparsed) ||
+        !xval.is_a(STRING)) {
+      return failed;
+    }
+    return extended_value::atom_t(xval);
+  }
+
+  std::string
+  encode_or_fail(std::string const& value)
+  {
+    try {
+      return detail::encode(value);
+    }
+    catch (fhicl::exception const&) {
+      return failed;
+    }
+  }
+
+  // Mostly plain text, with characters that need escaping, quotes and
+  // non-ASCII bytes mixed in.
+  std::string
+  random_string(std::mt19937& gen)
+  {
+    static std::string const plain{
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+      "_ .,:;-+*/#@!?=()[]{}<>$%&|~^`"};
+    static std::string const special{"\"'\\\n\t\r\x01\x7f\x80\xc3\xa9"};
+    std::uniform_int_distribution<std::size_t> length{0, 24};
+    std::uniform_int_distribution<int> percent{0, 99};
+    std::uniform_int_distribution<std::size_t> pick_plain{0,
+                                                          plain.size() - 1};
+    std::uniform_int_distribution<std::size_t> pick_special{
+      0, special.size() - 1};
+
+    std::string result;
+    for (auto n = length(gen); n != 0; --n) {
+      result += percent(gen) < 90 ? plain[pick_plain(gen)] :
+                                    special[pick_special(gen)];
+    }
+    switch (percent(gen) % 4) {
+    case 0:
+      return '"' + result + '"';
+    case 1:
+      return '\'' + result + '\'';
+    default:
+      return result;
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(encode_string_test)
+
+BOOST_AUTO_TEST_CASE(edge_cases)
+{
+  for (std::string const s : {"",
+                              "\"\"",
+                              "''",
+                              "\"",
+                              "'",
+                              "a",
+                              "a b",
+                              "'a b'",
+                              "\"a b\"",
+                              "'a\"",
+                              "\"a'",
+                              "it's",
+                              "\"a\\\"b\"",
+                              "a\\b",
+                              "a\tb",
+                              "a\nb",
+                              "true",
+                              "123",
+                              "@nil",
+                              "caf\xc3\xa9"}) {
+    BOOST_TEST(encode_or_fail(s) == reference_encode(s), s);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(random_strings)
+{
+  std::mt19937 gen{20240601};
+  for (std::size_t i = 0; i != 20000; ++i) {
+    auto const s = random_string(gen);
+    BOOST_TEST_CONTEXT(s)
+    {
+      BOOST_TEST(encode_or_fail(s) == reference_encode(s));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
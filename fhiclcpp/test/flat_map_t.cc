@@ -0,0 +1,87 @@
+// ======================================================================
+//
+// Check that detail::flat_map behaves like std::map for the operations
+// used by ParameterSet, including iteration order.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (flat map test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/detail/flat_map.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using fhicl::detail::flat_map;
+
+namespace {
+
+  template <typename Map>
+  std::vector<std::pair<std::string, int>>
+  contents(Map const& map)
+  {
+    return {map.begin(), map.end()};
+  }
+
+}
+
+BOOST_AUTO_TEST_SUITE(flat_map_test)
+
+BOOST_AUTO_TEST_CASE(basic_operations)
+{
+  flat_map<std::string, int> map;
+  BOOST_TEST(map.empty());
+  BOOST_TEST(map.emplace("b", 2).second);
+  BOOST_TEST(map.emplace("a", 1).second);
+  BOOST_TEST(map.emplace("c", 3).second);
+  BOOST_TEST(!map.emplace("b", 20).second);
+  BOOST_TEST(map.size() == 3u);
+  BOOST_TEST(map.find("b")->second == 2);
+  BOOST_TEST((map.find("d") == map.end()));
+
+  map["b"] = 22;
+  map["d"] = 4;
+  BOOST_TEST(map.find("b")->second == 22);
+  BOOST_TEST(map.size() == 4u);
+
+  BOOST_TEST(map.erase("a") == 1u);
+  BOOST_TEST(map.erase("a") == 0u);
+  std::vector<std::pair<std::string, int>> const expected{
+    {"b", 22}, {"c", 3}, {"d", 4}};
+  BOOST_TEST((contents(map) == expected));
+}
+
+BOOST_AUTO_TEST_CASE(same_as_std_map)
+{
+  std::map<std::string, int> reference;
+  flat_map<std::string, int> map;
+  std::mt19937 engine{2718};
+  std::uniform_int_distribution<int> key_dist{0, 200};
+  std::uniform_int_distribution<int> op_dist{0, 3};
+  for (int i = 0; i != 5000; ++i) {
+    auto const key = "k" + std::to_string(key_dist(engine));
+    switch (op_dist(engine)) {
+    case 0:
+      BOOST_TEST(map.emplace(key, i).second ==
+                 reference.emplace(key, i).second);
+      break;
+    case 1:
+      map[key] = i;
+      reference[key] = i;
+      break;
+    case 2:
+      BOOST_TEST(map.erase(key) == reference.erase(key));
+      break;
+    default:
+      BOOST_TEST((map.find(key) == map.end()) ==
+                 (reference.find(key) == reference.end()));
+    }
+  }
+  BOOST_TEST((contents(map) == contents(reference)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
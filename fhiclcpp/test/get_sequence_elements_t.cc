@@ -1,6 +1,7 @@
 #define BOOST_TEST_MODULE (get sequence elements test)
 
 #include "boost/test/unit_test.hpp"
+#include "fhiclcpp/KeyPath.h"
 #include "fhiclcpp/ParameterSet.h"
 
 #include <vector>
@@ -32,6 +33,16 @@ BOOST_AUTO_TEST_CASE(element_lookup)
   BOOST_TEST(pset.get<std::string>("h[1].h2") == "h2");
 }
 
+BOOST_AUTO_TEST_CASE(nested_element_lookup)
+{
+  // Every element of vv is distinct by position, so each index must be
+  // applied at its own level.
+  BOOST_TEST(pset.get<int>("vv[1][0]") == 2);
+  BOOST_TEST(pset.get<int>("vv[0][2]") == 3);
+  BOOST_TEST(pset.get<int>("vv[1][2]") == 4);
+  BOOST_TEST(pset.get<int>(KeyPath{"vv[1][2]"}) == 4);
+}
+
 BOOST_AUTO_TEST_CASE(element_container_lookup)
 {
   auto const vec0 = pset.get<std::vector<int>>("vv[0]");
@@ -0,0 +1,205 @@
+// ======================================================================
+//
+// Check that ParameterSets imported with
+// ParameterSetRegistry::importLazilyFrom are read from their files
+// only on demand, and are staged in and exported like those imported
+// with importFrom.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (lazy import test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/exception.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+#include "fhiclcpp/test/registry_test_helpers.h"
+
+#include "sqlite3.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+using fhicl::test::exported_rows;
+using fhicl::test::make_pset;
+namespace fs = std::filesystem;
+
+namespace {
+
+  // Writes the given ParameterSets (which must not contain nested
+  // tables) to a new database file.
+  void
+  write_db(fs::path const& path, std::vector<ParameterSet> const& psets)
+  {
+    fs::remove(path);
+    sqlite3* db = nullptr;
+    BOOST_TEST_REQUIRE(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+    BOOST_TEST_REQUIRE(
+      sqlite3_exec(db,
+                   "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+                   nullptr,
+                   nullptr,
+                   nullptr) == SQLITE_OK);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db,
+                       "INSERT INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);",
+                       -1,
+                       &stmt,
+                       nullptr);
+    for (auto const& ps : psets) {
+      auto const id = ps.id().to_string();
+      auto const blob = ps.to_compact_string();
+      sqlite3_bind_text(stmt, 1, id.c_str(), id.size() + 1, SQLITE_STATIC);
+      sqlite3_bind_text(
+        stmt, 2, blob.c_str(), blob.size() + 1, SQLITE_STATIC);
+      BOOST_TEST_REQUIRE(sqlite3_step(stmt) == SQLITE_DONE);
+      sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+  }
+
+  void
+  import_lazily(fs::path const& path)
+  {
+    sqlite3* db = nullptr;
+    BOOST_TEST_REQUIRE(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+    ParameterSetRegistry::importLazilyFrom(db);
+    sqlite3_close(db);
+  }
+
+  struct Files {
+    Files()
+    {
+      for (int i = 0; i != 4; ++i) {
+        psets.push_back(make_pset(i));
+      }
+      write_db(first, {psets[0], psets[1], psets[2]});
+      write_db(second, {psets[2], psets[3]});
+    }
+    ~Files()
+    {
+      fs::remove(first);
+      fs::remove(second);
+    }
+    fs::path const first{fs::temp_directory_path() / "lazy_import_t_1.db"};
+    fs::path const second{fs::temp_directory_path() / "lazy_import_t_2.db"};
+    std::vector<ParameterSet> psets;
+  };
+}
+
+BOOST_FIXTURE_TEST_SUITE(lazy_import_test, Files)
+
+BOOST_AUTO_TEST_CASE(lazy_import)
+{
+  BOOST_TEST_REQUIRE(ParameterSetRegistry::empty());
+  import_lazily(first);
+  import_lazily(second);
+
+  // Nothing is read until it is needed...
+  BOOST_TEST(ParameterSetRegistry::empty());
+  for (auto const& ps : psets) {
+    BOOST_TEST(!ParameterSetRegistry::has(ps.id()));
+  }
+
+  // ...and then only what is needed.
+  BOOST_TEST(ParameterSetRegistry::get(psets[3].id()) == psets[3]);
+  BOOST_TEST(ParameterSetRegistry::size() == 1u);
+  ParameterSet ps;
+  BOOST_TEST(ParameterSetRegistry::get(psets[0].id(), ps));
+  BOOST_TEST(ps == psets[0]);
+  BOOST_TEST(ParameterSetRegistry::size() == 2u);
+  BOOST_TEST(!ParameterSetRegistry::get(make_pset(4).id(), ps));
+
+  // Each ID is exported once.
+  BOOST_TEST(exported_rows() == psets.size());
+
+  ParameterSetRegistry::stageIn();
+  BOOST_TEST(ParameterSetRegistry::size() == psets.size());
+  for (auto const& ps : psets) {
+    BOOST_TEST(ParameterSetRegistry::has(ps.id()));
+  }
+  BOOST_TEST(exported_rows() == psets.size());
+}
+
+BOOST_AUTO_TEST_CASE(in_memory_fallback)
+{
+  // A database without a file is imported eagerly, into the backing
+  // DB, so it may be closed before its contents are needed.
+  auto const extra = make_pset(5);
+  sqlite3* db = nullptr;
+  sqlite3_open(":memory:", &db);
+  sqlite3_exec(db,
+               "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+               nullptr,
+               nullptr,
+               nullptr);
+  auto const sql = "INSERT INTO ParameterSets(ID, PSetBlob) VALUES('" +
+                   extra.id().to_string() + "', '" +
+                   extra.to_compact_string() + "');";
+  BOOST_TEST_REQUIRE(
+    sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+  ParameterSetRegistry::importLazilyFrom(db);
+  sqlite3_close(db);
+  BOOST_TEST(!ParameterSetRegistry::has(extra.id()));
+  BOOST_TEST(ParameterSetRegistry::get(extra.id()) == extra);
+}
+
+BOOST_AUTO_TEST_CASE(file_replaced)
+{
+  // The file is read through the connection opened on import.
+  auto const ps = make_pset(6);
+  write_db(first, {ps});
+  import_lazily(first);
+  write_db(first, {make_pset(7)});
+  BOOST_TEST(ParameterSetRegistry::get(ps.id()) == ps);
+  fs::remove(first);
+  BOOST_TEST(ParameterSetRegistry::get(ps.id()) == ps);
+}
+
+BOOST_AUTO_TEST_CASE(other_vfs_fallback)
+{
+  // A database opened through another VFS may not be reopened by name,
+  // so it is imported eagerly.
+  auto vfs = *sqlite3_vfs_find(nullptr);
+  vfs.zName = "lazy_import_t";
+  BOOST_TEST_REQUIRE(sqlite3_vfs_register(&vfs, 0) == SQLITE_OK);
+  auto const ps = make_pset(8);
+  write_db(first, {ps});
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(sqlite3_open_v2(first.c_str(),
+                                     &db,
+                                     SQLITE_OPEN_READWRITE,
+                                     vfs.zName) == SQLITE_OK);
+  ParameterSetRegistry::importLazilyFrom(db);
+  BOOST_TEST_REQUIRE(sqlite3_exec(db,
+                                  "DELETE FROM ParameterSets;",
+                                  nullptr,
+                                  nullptr,
+                                  nullptr) == SQLITE_OK);
+  sqlite3_close(db);
+  sqlite3_vfs_unregister(&vfs);
+  BOOST_TEST(ParameterSetRegistry::get(ps.id()) == ps);
+}
+
+BOOST_AUTO_TEST_CASE(null_id_rejected)
+{
+  write_db(first, {make_pset(9)});
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(sqlite3_open(first.c_str(), &db) == SQLITE_OK);
+  BOOST_TEST_REQUIRE(
+    sqlite3_exec(db,
+                 "INSERT INTO ParameterSets(ID, PSetBlob) VALUES(NULL, '');",
+                 nullptr,
+                 nullptr,
+                 nullptr) == SQLITE_OK);
+  BOOST_CHECK_THROW(ParameterSetRegistry::importLazilyFrom(db),
+                    fhicl::exception);
+  sqlite3_close(db);
+  BOOST_TEST(!ParameterSetRegistry::has(make_pset(9).id()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
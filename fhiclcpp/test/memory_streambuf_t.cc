@@ -0,0 +1,72 @@
+// ======================================================================
+//
+// test memory_streambuf: reading characters in place as a stream
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (memory streambuf test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/detail/memory_streambuf.h"
+#include "fhiclcpp/intermediate_table.h"
+#include "fhiclcpp/parse.h"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+using fhicl::detail::memory_streambuf;
+
+BOOST_AUTO_TEST_SUITE(memory_streambuf_test)
+
+BOOST_AUTO_TEST_CASE(read_lines)
+{
+  std::string const text{"a: 1\n#include \"x.fcl\"\n\nb: 2"};
+  memory_streambuf buf{text};
+  std::istream is{&buf};
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(is, line);) {
+    lines.push_back(line);
+  }
+  std::vector<std::string> const expected{
+    "a: 1", "#include \"x.fcl\"", "", "b: 2"};
+  BOOST_TEST(lines == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(read_in_place)
+{
+  std::string text{"abc"};
+  memory_streambuf buf{text};
+  std::istream is{&buf};
+  text[1] = 'X';
+  std::string word;
+  is >> word;
+  BOOST_TEST(word == "aXc");
+}
+
+BOOST_AUTO_TEST_CASE(positioning)
+{
+  std::string const text{"0123456789"};
+  memory_streambuf buf{text};
+  std::istream is{&buf};
+  is.seekg(4);
+  BOOST_TEST(is.tellg() == 4);
+  BOOST_TEST(is.get() == '4');
+  is.seekg(-2, std::ios_base::end);
+  BOOST_TEST(is.get() == '8');
+  is.seekg(-3, std::ios_base::cur);
+  BOOST_TEST(is.get() == '6');
+  is.seekg(11);
+  BOOST_TEST(is.fail());
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+  memory_streambuf buf{std::string_view{}};
+  std::istream is{&buf};
+  std::string line;
+  BOOST_TEST(!std::getline(is, line));
+  BOOST_TEST(fhicl::parse_document("").empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,224 @@
+// ======================================================================
+//
+// test that the parser backends agree: every document (and value
+// string) must yield identical values -- including source locations,
+// protections and PROLOG membership -- or identical errors.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (parse backends test)
+#include "boost/test/unit_test.hpp"
+
+#include "cetlib/filepath_maker.h"
+#include "fhiclcpp/exception.h"
+#include "fhiclcpp/extended_value.h"
+#include "fhiclcpp/intermediate_table.h"
+#include "fhiclcpp/parse.h"
+
+#include <any>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace fhicl;
+using namespace std::string_literals;
+
+namespace {
+
+  // Restores the backend selected on entry, whatever happens.
+  class backend_sentry {
+  public:
+    backend_sentry() : saved_{active_parser_backend()} {}
+    ~backend_sentry() { set_parser_backend(saved_); }
+
+  private:
+    parser_backend saved_;
+  };
+
+  // Flattens everything observable about a parse: each value's tag,
+  // PROLOG membership, protection and source location, atoms as
+  // stored, and the text of any exception.
+  void
+  describe(std::string const& key,
+           extended_value const& v,
+           std::vector<std::string>& out)
+  {
+    out.push_back(key + " tag=" + std::to_string(v.tag) +
+                  " prolog=" + std::to_string(v.in_prolog) + " protection=" +
+                  to_string(v.protection) + " src=" + v.src_info);
+    switch (v.tag) {
+    case SEQUENCE: {
+      auto const& seq =
+        std::any_cast<extended_value::sequence_t const&>(v.value);
+      for (std::size_t i = 0; i != seq.size(); ++i) {
+        describe(key + '[' + std::to_string(i) + ']', seq[i], out);
+      }
+      break;
+    }
+    case TABLE: {
+      auto const& tbl =
+        std::any_cast<extended_value::table_t const&>(v.value);
+      for (auto const& [name, value] : tbl) {
+        describe(key + '.' + name, value, out);
+      }
+      break;
+    }
+    default:
+      out.push_back(key + " = " + v.to_string());
+    }
+  }
+
+  std::vector<std::string>
+  outcome(parser_backend const backend,
+          std::function<intermediate_table()> const& parse)
+  {
+    set_parser_backend(backend);
+    std::vector<std::string> result;
+    try {
+      auto const tbl = parse();
+      for (auto const& [name, value] : tbl) {
+        describe(name, value, result);
+      }
+    }
+    catch (std::exception const& e) {
+      result.push_back("exception: "s + e.what());
+    }
+    return result;
+  }
+
+  void
+  check_agreement(std::string const& what,
+                  std::function<intermediate_table()> const& parse)
+  {
+    BOOST_TEST_CONTEXT(what)
+    {
+      auto const spirit = outcome(parser_backend::spirit, parse);
+      auto const rd = outcome(parser_backend::recursive_descent, parse);
+      BOOST_TEST(spirit == rd, boost::test_tools::per_element());
+    }
+  }
+
+  std::vector<std::string> const documents{
+    "",
+    "   # comment only\n",
+    "// comment without newline",
+    "a: 1 b: 2.5e3 c: -0x1F d: 0b101 e: +infinity f: -infinity g: nil",
+    "a: true b: false c: (1, -2.5) d: 'single' e: \"double\\n\" f: bare",
+    "a: [] b: [1, [2, [3]], {x: 1}] c: {} d: { e: { f: [ g ] } }",
+    "a.b.c: 1 a.d[0]: 2",
+    "a: [1, 2] a[1]: 3 a[3]: 4",
+    "BEGIN_PROLOG x: 1 t: { a: 1 b: [1, 2] } END_PROLOG\n"
+    "y: @local::x z: @local::t.b u: { @table::t c: 3 }\n"
+    "v: [ @sequence::t.b, 5 ]",
+    "BEGIN_PROLOG t: { a: 1 } END_PROLOG @table::t b: 2",
+    "x @protect_ignore: 1 x: 2 y @protect_error: { a: 1 } z: @erase",
+    "x @protect_error: 1 x: 2",
+    "x: { a @protect_error: 1 } x.a: 2",
+    "x @protect_ignore: { a @protect_error: 1 }",
+    "x @protect_error: 1 x: @erase",
+    "t: { a: 1 a: @erase b @protect_ignore: 2 b: 3 }",
+    "a: @id::0123456789abcdef0123456789abcdef",
+    "a: @db::x",
+    "a: @local::missing",
+    "a: 1 b: @table::a",
+    "a: 1 b: [ @sequence::a ]",
+    "a: { b: 1 ",
+    "a: [ 1, ]",
+    "a: [ , 1 ]",
+    "a: 1 b",
+    "a : 1 b. c: 2",
+    "a: 1 b : @local :: a",
+    "a: 'unterminated",
+    "a: \"bad \\q escape\"",
+    "a: 1.2.3",
+    "a: ( 1, ",
+    "BEGIN_PROLOG a: 1",
+    "a: 1 BEGIN_PROLOG b: 2 END_PROLOG",
+    "END_PROLOG",
+    "a: 1\n  # trailing comment\n b:",
+    "a: 1 // c++ comment\n b: 2 # hash comment\n",
+    "a: 1 }",
+    "1: 2",
+    "a[x]: 1",
+    "a: {b: 1} a.b.c: 2",
+  };
+
+  std::vector<std::string> const value_strings{
+    "", "1", " -2.5e-3 ", "0x10", "infinity", "nil", "true", "(1,2)",
+    "'a'", "\"b\"", "bare", "[1, [2, 3], {a: 1}]", "{a: 1 b: [2]}",
+    "[1, 2", "{a: 1", "1 2", "@local::x", "[1, ]", "(1,", "a.b",
+  };
+
+}
+
+BOOST_AUTO_TEST_SUITE(parse_backends_test)
+
+BOOST_AUTO_TEST_CASE(documents_agree)
+{
+  backend_sentry const sentry;
+  for (auto const& doc : documents) {
+    check_agreement(doc, [&doc] { return parse_document(doc); });
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_files_agree)
+{
+  backend_sentry const sentry;
+  auto const* const path = std::getenv("FHICL_FILE_PATH");
+  BOOST_REQUIRE(path != nullptr);
+  auto const root = std::string{std::string_view{path}.substr(
+    0, std::string_view{path}.find(':'))};
+  cet::filepath_lookup_nonabsolute policy("FHICL_FILE_PATH");
+  std::size_t n{};
+  for (auto const* subdir : {"testFiles/pass", "testFiles/fail"}) {
+    for (auto const& entry :
+         std::filesystem::directory_iterator(root + '/' + subdir)) {
+      if (entry.path().extension() != ".fcl") {
+        continue;
+      }
+      auto const name = subdir + ("/"s += entry.path().filename().string());
+      check_agreement(
+        name, [&name, &policy] { return parse_document(name, policy); });
+      ++n;
+    }
+  }
+  BOOST_TEST(n > 0u);
+}
+
+BOOST_AUTO_TEST_CASE(value_strings_agree)
+{
+  backend_sentry const sentry;
+  for (auto const& s : value_strings) {
+    std::vector<std::string> results;
+    for (auto const backend :
+         {parser_backend::spirit, parser_backend::recursive_descent}) {
+      set_parser_backend(backend);
+      extended_value v;
+      std::string unparsed;
+      std::string result;
+      try {
+        result = parse_value_string(s, v, unparsed) ? v.to_string() :
+                                                      "unparsed: " + unparsed;
+      }
+      catch (std::exception const&) {
+        // The grammar throws upon an incomplete construct where the
+        // recursive-descent parser reports it as unparsed.
+        result = "incomplete";
+      }
+      results.push_back(result);
+    }
+    BOOST_TEST_CONTEXT(s)
+    {
+      if (results[0] == "incomplete") {
+        BOOST_TEST(results[1].starts_with("unparsed: "));
+      } else {
+        BOOST_TEST(results[0] == results[1]);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
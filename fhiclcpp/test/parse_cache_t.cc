@@ -0,0 +1,207 @@
+// ======================================================================
+//
+// test the cache of parsed documents (fhicl::enable_parse_cache)
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (parse cache test)
+
+#include "boost/test/unit_test.hpp"
+#include "cetlib/filepath_maker.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/detail/parse_cache.h"
+#include "fhiclcpp/exception.h"
+#include "fhiclcpp/intermediate_table.h"
+#include "fhiclcpp/parse.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+using namespace fhicl;
+namespace fs = std::filesystem;
+
+namespace {
+
+  // Resolves names relative to a directory, counting the lookups.
+  class counting_maker : public cet::filepath_maker {
+  public:
+    explicit counting_maker(fs::path dir) : dir_{std::move(dir)} {}
+
+    std::string
+    operator()(std::string const& filename) override
+    {
+      ++calls[filename];
+      return (dir_ / filename).string();
+    }
+
+    std::map<std::string, std::size_t> calls;
+
+  private:
+    fs::path dir_;
+  };
+
+  struct Files {
+    Files()
+    {
+      fs::remove_all(dir);
+      fs::create_directories(dir);
+      write("prolog.fcl",
+            "BEGIN_PROLOG\n"
+            "defaults: { a @protect_ignore: 1 b: [1, (2, 3), 'x'] }\n"
+            "END_PROLOG\n");
+      write("top.fcl",
+            "#include \"prolog.fcl\"\n"
+            "t: { @table::defaults c: 4 }\n"
+            "u: @local::defaults.b\n");
+    }
+    ~Files()
+    {
+      disable_parse_cache();
+      fs::remove_all(dir);
+    }
+
+    void
+    write(std::string const& name, std::string const& text) const
+    {
+      std::ofstream{dir / name} << text;
+    }
+
+    std::string
+    parse(std::string const& name)
+    {
+      counting_maker maker{dir};
+      auto tbl = parse_document(name, maker);
+      calls = maker.calls;
+      return ParameterSet::make(tbl).to_indented_string(0, true);
+    }
+
+    fs::path const dir{fs::temp_directory_path() / "parse_cache_t"};
+    std::map<std::string, std::size_t> calls;
+  };
+
+  bool
+  same_stats(std::size_t const hits, std::size_t const misses)
+  {
+    auto const stats = parse_cache_stats();
+    return stats.hits == hits && stats.misses == misses;
+  }
+}
+
+BOOST_FIXTURE_TEST_SUITE(parse_cache_test, Files)
+
+BOOST_AUTO_TEST_CASE(disabled)
+{
+  auto const uncached = parse("top.fcl");
+  BOOST_TEST(same_stats(0, 0));
+  enable_parse_cache();
+  BOOST_TEST(parse("top.fcl") == uncached);
+  BOOST_TEST(parse("top.fcl") == uncached);
+  BOOST_TEST(same_stats(1, 1));
+  disable_parse_cache();
+  BOOST_TEST(parse("top.fcl") == uncached);
+  BOOST_TEST(same_stats(0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(each_name_resolved_once)
+{
+  enable_parse_cache();
+  std::map<std::string, std::size_t> const once{{"prolog.fcl", 1},
+                                                {"top.fcl", 1}};
+  parse("top.fcl");
+  BOOST_TEST((calls == once));
+  parse("top.fcl");
+  BOOST_TEST((calls == once));
+  BOOST_TEST(same_stats(1, 1));
+}
+
+BOOST_AUTO_TEST_CASE(included_file_changed)
+{
+  enable_parse_cache();
+  auto const before = parse("top.fcl");
+  write("prolog.fcl",
+        "BEGIN_PROLOG\n"
+        "defaults: { a: 10 b: [] }\n"
+        "END_PROLOG\n");
+  auto const after = parse("top.fcl");
+  BOOST_TEST(after != before);
+  BOOST_TEST(same_stats(0, 2));
+  BOOST_TEST(ParameterSet::make(after).get<int>("t.a") == 10);
+  BOOST_TEST(parse("top.fcl") == after);
+  BOOST_TEST(same_stats(1, 2));
+}
+
+BOOST_AUTO_TEST_CASE(shared_include)
+{
+  write("other.fcl",
+        "#include \"prolog.fcl\"\n"
+        "v: @local::defaults.a\n");
+  enable_parse_cache();
+  parse("top.fcl");
+  parse("other.fcl");
+  BOOST_TEST(same_stats(0, 2));
+  parse("other.fcl");
+  BOOST_TEST(same_stats(1, 2));
+}
+
+BOOST_AUTO_TEST_CASE(errors_not_cached)
+{
+  write("bad.fcl", "#include \"prolog.fcl\"\nx: { y: 1\n");
+  enable_parse_cache();
+  BOOST_CHECK_THROW(parse("bad.fcl"), fhicl::exception);
+  BOOST_CHECK_THROW(parse("bad.fcl"), fhicl::exception);
+  BOOST_TEST(same_stats(0, 2));
+}
+
+BOOST_AUTO_TEST_CASE(on_disk)
+{
+  auto const store = dir / "store";
+  enable_parse_cache(8, store.string());
+  auto const result = parse("top.fcl");
+  BOOST_TEST(same_stats(0, 1));
+
+  // A new cache holds nothing in memory, but finds the stored result.
+  enable_parse_cache(8, store.string());
+  BOOST_TEST(parse("top.fcl") == result);
+  BOOST_TEST(same_stats(1, 0));
+
+  // Unreadable files are replaced.
+  for (auto const& entry : fs::directory_iterator{store}) {
+    std::ofstream{entry.path()} << "garbage";
+  }
+  enable_parse_cache(8, store.string());
+  BOOST_TEST(parse("top.fcl") == result);
+  BOOST_TEST(same_stats(0, 1));
+  enable_parse_cache(8, store.string());
+  BOOST_TEST(parse("top.fcl") == result);
+  BOOST_TEST(same_stats(1, 0));
+}
+
+BOOST_AUTO_TEST_CASE(binary_round_trip)
+{
+  auto const tbl = parse_document(
+    "BEGIN_PROLOG p: { q: 1 } END_PROLOG\n"
+    "a @protect_error: { b: [1, [2, {c: @nil}], (3, -4)] d: @id::"
+    "0123456789abcdef0123456789abcdef01234567 }\n"
+    "e @protect_ignore: 'text' f: true g: []");
+  auto const bytes = detail::parse_cache::to_binary(tbl);
+  auto const copy = detail::parse_cache::from_binary(bytes);
+  BOOST_TEST(detail::parse_cache::to_binary(copy) == bytes);
+  BOOST_TEST(copy.find("p.q").in_prolog);
+  BOOST_TEST((copy.find("a").protection == Protection::PROTECT_ERROR));
+  BOOST_TEST(copy.find("a.b").src_info == tbl.find("a.b").src_info);
+  BOOST_TEST(copy.find("a.b.1.1.c").is_a(NIL));
+  BOOST_TEST(copy.find("a.b.2").is_a(COMPLEX));
+  BOOST_TEST(copy.find("a.d").is_a(TABLEID));
+  BOOST_TEST((copy.find("e").protection == Protection::PROTECT_IGNORE));
+  BOOST_TEST(copy.find("g").is_a(SEQUENCE));
+
+  BOOST_CHECK_THROW(detail::parse_cache::from_binary(bytes.substr(0, 20)),
+                    fhicl::exception);
+  BOOST_CHECK_THROW(detail::parse_cache::from_binary("a: 1"),
+                    fhicl::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
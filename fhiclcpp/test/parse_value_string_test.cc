@@ -125,4 +125,46 @@ BOOST_AUTO_TEST_CASE(everything_else)
   BOOST_CHECK(parse_as("{a : 3 b: 7 a: @erase}") == "{b:7}");
 }
 
+BOOST_AUTO_TEST_CASE(simple_values)
+{
+  // Simple values are recognized without the grammar, except when
+  // surrounded by whitespace: both must agree.
+  auto const tagged_parse = [](string const& input) {
+    extended_value result;
+    string unparsed;
+    return parse_value_string(input, result, unparsed) ?
+             std::to_string(result.tag) + ' ' + result.to_string() :
+             failed;
+  };
+  for (string const s : {"true",
+                         "false",
+                         "True",
+                         "infinity",
+                         "e",
+                         "E",
+                         "e5",
+                         "eE",
+                         "_",
+                         "module_label",
+                         "x1",
+                         "0",
+                         "000",
+                         "007",
+                         "1234567",
+                         "''",
+                         "'a b'",
+                         "'\\t'",
+                         "'a\"b'",
+                         "'caf\xc3\xa9'",
+                         "\"\"",
+                         "\"a b\"",
+                         "\"a\\\"b\"",
+                         "\"a\\\"",
+                         "\"a\\\\\"",
+                         "\"\\t\"",
+                         "\"caf\xc3\xa9\""}) {
+    BOOST_TEST(tagged_parse(s) == tagged_parse(' ' + s + ' '), s);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+// ======================================================================
+//
+// Check, by counting heap allocations, that inserting a value into a
+// ParameterSet does not copy its encoded representation, and that
+// values passed as rvalues are moved rather than copied.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (put allocations test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+  bool counting{false};
+  std::size_t allocations{};
+
+  // Number of heap allocations made by f.
+  template <typename F>
+  std::size_t
+  allocations_in(F f)
+  {
+    allocations = 0;
+    counting = true;
+    f();
+    counting = false;
+    return allocations;
+  }
+
+  // Kept out of line so that the compiler does not pair the
+  // replacement operator delete with the allocation functions.
+  [[gnu::noinline]] void
+  release(void* p) noexcept
+  {
+    std::free(p);
+  }
+
+  std::vector<int>
+  make_values()
+  {
+    std::vector<int> result;
+    for (int i = 0; i != 1000; ++i) {
+      result.push_back(i);
+    }
+    return result;
+  }
+
+  ParameterSet
+  make_table()
+  {
+    ParameterSet result;
+    for (int i = 0; i != 1000; ++i) {
+      result.put("p" + std::to_string(i),
+                 "a string too long for SSO " + std::to_string(i));
+    }
+    return result;
+  }
+}
+
+void*
+operator new(std::size_t const size)
+{
+  if (counting) {
+    ++allocations;
+  }
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void
+operator delete(void* p) noexcept
+{
+  release(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  release(p);
+}
+
+BOOST_AUTO_TEST_SUITE(put_allocations_t)
+
+BOOST_AUTO_TEST_CASE(sequence_not_copied)
+{
+  auto const values = make_values();
+  auto const encoding = allocations_in(
+    [&values] { detail::ps_sequence_t const seq = detail::encode(values); });
+
+  // Beyond the encoding itself: the std::any holding the sequence, and
+  // the storage for the new entry.
+  constexpr std::size_t overhead{2};
+
+  ParameterSet pset;
+  BOOST_TEST(allocations_in([&pset, &values] { pset.put("a", values); }) <=
+             encoding + overhead);
+  BOOST_TEST(allocations_in([&pset, &values] {
+               pset.put_or_replace("a", values);
+             }) <= encoding + overhead);
+  BOOST_TEST(allocations_in([&pset, &values] {
+               pset.put_or_replace_compatible("a", values);
+             }) <= encoding + overhead);
+  BOOST_TEST(pset.get<std::vector<int>>("a") == values);
+}
+
+BOOST_AUTO_TEST_CASE(table_moved)
+{
+  auto table = make_table();
+  auto const copy_allocations =
+    allocations_in([&table] { ParameterSet const copy{table}; });
+  auto const expected = table;
+  // The ID is cached by the table, so that only the insertion itself
+  // is counted below.
+  (void)table.id();
+
+  ParameterSet pset;
+  auto const moving = allocations_in(
+    [&pset, &table] { pset.put("t", std::move(table)); });
+  BOOST_TEST(moving < copy_allocations / 10);
+  BOOST_TEST(pset.get<ParameterSet>("t") == expected);
+  BOOST_TEST(ParameterSetRegistry::has(expected.id()));
+}
+
+BOOST_AUTO_TEST_CASE(emplace)
+{
+  ParameterSet pset;
+  pset.emplace<std::vector<std::string>>("a", 3, "x");
+  pset.emplace<ParameterSet>("b");
+  BOOST_TEST(pset.get<std::vector<std::string>>("a") ==
+             (std::vector<std::string>{"x", "x", "x"}));
+  BOOST_TEST(pset.get<ParameterSet>("b").is_empty());
+  BOOST_CHECK_THROW(pset.emplace<int>("a", 1), fhicl::exception);
+  BOOST_TEST(pset.get<std::vector<std::string>>("a").size() == 3u);
+
+  // Beyond building and encoding the value: the std::any holding the
+  // sequence, and the storage for the new entry.
+  auto const building = allocations_in([] {
+    detail::ps_sequence_t const seq =
+      detail::encode(std::vector<int>(1000, 7));
+  });
+  constexpr std::size_t overhead{2};
+  BOOST_TEST(allocations_in([&pset] {
+               pset.emplace<std::vector<int>>("c", 1000, 7);
+             }) <= building + overhead);
+  BOOST_TEST(pset.get<std::vector<int>>("c") == std::vector<int>(1000, 7));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,217 @@
+// ======================================================================
+//
+// Check that a ParameterSetRegistry with a memory budget evicts its
+// least recently used ParameterSets, reloads them on demand, and
+// keeps pinned ones resident.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (registry budget test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+#include "fhiclcpp/test/registry_test_helpers.h"
+
+#include "sqlite3.h"
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fhicl;
+using fhicl::test::export_registry;
+using fhicl::test::make_pset;
+
+BOOST_AUTO_TEST_SUITE(registry_budget_test)
+
+BOOST_AUTO_TEST_CASE(eviction)
+{
+  // Registered while unbounded, so never evicted.
+  auto const permanent = make_pset(-1);
+  ParameterSetRegistry::put(permanent);
+
+  std::vector<ParameterSet> psets;
+  for (int i = 0; i != 20; ++i) {
+    psets.push_back(make_pset(i));
+  }
+  auto const bytes = psets[10].to_binary_string().size();
+  ParameterSetRegistry::set_memory_budget(4 * bytes);
+  BOOST_TEST(ParameterSetRegistry::memory_budget() == 4 * bytes);
+
+  for (auto const& ps : psets) {
+    ParameterSetRegistry::put(ps);
+  }
+  auto stats = ParameterSetRegistry::statistics();
+  BOOST_TEST(stats.evictions > 0u);
+  BOOST_TEST(stats.resident_bytes <= 4 * bytes);
+  BOOST_TEST(ParameterSetRegistry::size() < psets.size());
+  BOOST_TEST(ParameterSetRegistry::get().contains(permanent.id()));
+
+  // Evicted ParameterSets are still known, and are reloaded.
+  for (auto const& ps : psets) {
+    BOOST_TEST(ParameterSetRegistry::has(ps.id()));
+  }
+  BOOST_TEST(!ParameterSetRegistry::has(make_pset(20).id()));
+  auto const misses = ParameterSetRegistry::statistics().misses;
+  BOOST_TEST(ParameterSetRegistry::get(psets[0].id()) == psets[0]);
+  BOOST_TEST(ParameterSetRegistry::statistics().misses == misses + 1);
+  auto const hits = ParameterSetRegistry::statistics().hits;
+  BOOST_TEST(ParameterSetRegistry::get(psets[0].id()) == psets[0]);
+  BOOST_TEST(ParameterSetRegistry::statistics().hits == hits + 1);
+
+  // Everything is exported, resident or not, and as text: evicted
+  // ParameterSets are spilled in binary.
+  auto const rows = export_registry();
+  BOOST_TEST(rows.size() == psets.size() + 1);
+  for (auto const& row : rows) {
+    BOOST_TEST(row.type == SQLITE_TEXT);
+    BOOST_TEST(ParameterSet::make(row.psBlob).id().to_string() == row.id);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(pinning)
+{
+  auto const pinned = make_pset(100);
+  ParameterSetRegistry::put(pinned);
+  auto const& ref = ParameterSetRegistry::pin(pinned.id());
+  for (int i = 101; i != 120; ++i) {
+    ParameterSetRegistry::put(make_pset(i));
+  }
+  BOOST_TEST(ParameterSetRegistry::get().contains(pinned.id()));
+  BOOST_TEST(ref == pinned);
+
+  ParameterSetRegistry::unpin(pinned.id());
+  for (int i = 120; i != 140; ++i) {
+    ParameterSetRegistry::put(make_pset(i));
+  }
+  BOOST_TEST(!ParameterSetRegistry::get().contains(pinned.id()));
+  BOOST_TEST(ParameterSetRegistry::get(pinned.id()) == pinned);
+}
+
+BOOST_AUTO_TEST_CASE(nested_tables)
+{
+  // Nested tables are registered, and so may be evicted, separately.
+  ParameterSet outer;
+  outer.put("inner", make_pset(300));
+  outer.put("more", std::vector<ParameterSet>{make_pset(301), make_pset(302)});
+  ParameterSetRegistry::put(outer);
+  for (int i = 303; i != 330; ++i) {
+    ParameterSetRegistry::put(make_pset(i));
+  }
+  BOOST_TEST(!ParameterSetRegistry::get().contains(outer.id()));
+  auto const& reloaded = ParameterSetRegistry::get(outer.id());
+  BOOST_TEST(reloaded == outer);
+  BOOST_TEST(reloaded.get<ParameterSet>("inner") == make_pset(300));
+  BOOST_TEST(reloaded.get<std::vector<ParameterSet>>("more").size() == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(text_reload)
+{
+  // Reloading a ParameterSet stored as text registers its nested
+  // tables, which evict nothing until the next registration.
+  ParameterSet outer;
+  outer.put("inner", make_pset(400));
+  outer.put("more", std::vector<ParameterSet>{make_pset(401), make_pset(402)});
+  auto const id = outer.id().to_string();
+  auto const text = outer.to_compact_string();
+  sqlite3* db = nullptr;
+  sqlite3_open(":memory:", &db);
+  sqlite3_exec(db,
+               "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+               nullptr,
+               nullptr,
+               nullptr);
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(
+    db, "INSERT INTO ParameterSets VALUES(?, ?);", -1, &stmt, nullptr);
+  sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 2, text.c_str(), -1, SQLITE_STATIC);
+  BOOST_TEST_REQUIRE(sqlite3_step(stmt) == SQLITE_DONE);
+  sqlite3_finalize(stmt);
+  ParameterSetRegistry::importFrom(db);
+  sqlite3_close(db);
+
+  for (int i = 403; i != 430; ++i) {
+    ParameterSetRegistry::put(make_pset(i));
+  }
+  auto const inner_id = make_pset(400).id();
+  BOOST_TEST_REQUIRE(!ParameterSetRegistry::get().contains(inner_id));
+  auto const evictions = ParameterSetRegistry::statistics().evictions;
+  auto const& reloaded = ParameterSetRegistry::get(outer.id());
+  BOOST_TEST(ParameterSetRegistry::statistics().evictions == evictions);
+  BOOST_TEST(reloaded == outer);
+  BOOST_TEST(ParameterSetRegistry::get().contains(inner_id));
+  BOOST_TEST(reloaded.get<ParameterSet>("inner") == make_pset(400));
+  BOOST_TEST(reloaded.get<std::vector<ParameterSet>>("more").size() == 2u);
+
+  ParameterSetRegistry::put(make_pset(430));
+  BOOST_TEST(ParameterSetRegistry::statistics().evictions > evictions);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_nested_reads)
+{
+  // Nested tables are read (by get, to_string and walk) while
+  // registrations on another thread evict them.
+  auto const bytes = make_pset(10).to_binary_string().size();
+  ParameterSetRegistry::set_memory_budget(4 * bytes);
+  std::vector<ParameterSet> outers;
+  std::vector<std::string> expected;
+  for (int i = 0; i != 8; ++i) {
+    ParameterSet middle;
+    middle.put("inner", make_pset(1000 + i));
+    middle.put("j", i);
+    ParameterSet outer;
+    outer.put("middle", middle);
+    expected.push_back(outer.to_string());
+    outers.push_back(std::move(outer));
+  }
+  auto const evictions = ParameterSetRegistry::statistics().evictions;
+
+  std::atomic<bool> done{false};
+  std::atomic<std::size_t> failures{};
+  auto read = [&outers, &expected, &done, &failures] {
+    while (!done) {
+      for (int i = 0; i != 8; ++i) {
+        auto const& outer = outers[i];
+        if (outer.get<int>("middle.inner.i") != 1000 + i ||
+            outer.get<int>("middle.j") != i ||
+            outer.to_string() != expected[i] ||
+            outer.to_indented_string().empty()) {
+          ++failures;
+        }
+      }
+    }
+  };
+  std::vector<std::thread> readers;
+  for (int i = 0; i != 4; ++i) {
+    readers.emplace_back(read);
+  }
+  for (int i = 2000; i != 7000; ++i) {
+    ParameterSetRegistry::put(make_pset(i));
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  BOOST_TEST(failures == 0u);
+  BOOST_TEST(ParameterSetRegistry::statistics().evictions > evictions);
+}
+
+BOOST_AUTO_TEST_CASE(unbounded_again)
+{
+  ParameterSetRegistry::set_memory_budget(0);
+  BOOST_TEST(ParameterSetRegistry::statistics().resident_bytes == 0u);
+  auto const evictions = ParameterSetRegistry::statistics().evictions;
+  auto const size = ParameterSetRegistry::size();
+  for (int i = 200; i != 220; ++i) {
+    ParameterSetRegistry::put(make_pset(i));
+  }
+  BOOST_TEST(ParameterSetRegistry::statistics().evictions == evictions);
+  BOOST_TEST(ParameterSetRegistry::size() == size + 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+// ======================================================================
+//
+// Check the latency histograms of the ParameterSetRegistry metrics
+// and, when they are compiled in (FHICLCPP_REGISTRY_METRICS), that
+// registry operations are recorded; otherwise, that nothing is.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (registry metrics test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/detail/registry_metrics.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+
+#include "sqlite3.h"
+
+#include <chrono>
+#include <sstream>
+
+using namespace fhicl;
+using namespace std::chrono_literals;
+using detail::registry_op;
+
+BOOST_AUTO_TEST_SUITE(registry_metrics_test)
+
+BOOST_AUTO_TEST_CASE(histogram)
+{
+  detail::latency_histogram h;
+  BOOST_TEST(h.quantile_ns(0.5) == 0u);
+  h.record(0ns);
+  h.record(100ns);  // [64, 128)
+  h.record(100ns);
+  h.record(5000ns); // [4096, 8192)
+  BOOST_TEST(h.count() == 4u);
+  BOOST_TEST(h.total_ns() == 5200u);
+  BOOST_TEST(h.bucket(0) == 1u);
+  BOOST_TEST(h.bucket(6) == 2u);
+  BOOST_TEST(h.bucket(12) == 1u);
+  BOOST_TEST(h.quantile_ns(0.5) == 128u);
+  BOOST_TEST(h.quantile_ns(0.99) == 8192u);
+  h.reset();
+  BOOST_TEST(h.count() == 0u);
+  BOOST_TEST(h.bucket(6) == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(registry_operations)
+{
+  auto& metrics = ParameterSetRegistry::metrics();
+  metrics.reset();
+
+  ParameterSet ps;
+  ps.put("a", 1);
+  auto const id = ParameterSetRegistry::put(ps);
+  ParameterSetRegistry::get(id);
+
+  // A lookup that falls back to the backing DB.
+  ParameterSet other;
+  other.put("b", 2);
+  sqlite3* db = nullptr;
+  sqlite3_open(":memory:", &db);
+  ParameterSetRegistry::exportTo(db);
+  sqlite3_exec(db,
+               ("INSERT INTO ParameterSets(ID, PSetBlob) VALUES('" +
+                other.id().to_string() + "', '" + other.to_compact_string() +
+                "');")
+                 .c_str(),
+               nullptr,
+               nullptr,
+               nullptr);
+  ParameterSetRegistry::importFrom(db);
+  sqlite3_close(db);
+  BOOST_TEST(ParameterSetRegistry::get(other.id()) == other);
+
+  std::uint64_t const expected = detail::registry_metrics_enabled ? 1 : 0;
+  BOOST_TEST(metrics[registry_op::put].count() == expected);
+  BOOST_TEST(metrics[registry_op::get].count() == 2 * expected);
+  BOOST_TEST(metrics[registry_op::find].count() == expected);
+  BOOST_TEST(metrics[registry_op::import].count() == expected);
+  BOOST_TEST(metrics[registry_op::export_to].count() == expected);
+  BOOST_TEST(metrics.db_fallbacks == expected);
+  BOOST_TEST(metrics.blobs_parsed == expected);
+  BOOST_TEST(metrics.bytes_parsed > 0u == detail::registry_metrics_enabled);
+  BOOST_TEST(metrics.lock_hold.count() == metrics.lock_wait.count());
+  BOOST_TEST(metrics.lock_wait.count() > 0u ==
+             detail::registry_metrics_enabled);
+
+  std::ostringstream os;
+  metrics.print(os);
+  BOOST_TEST(!os.str().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
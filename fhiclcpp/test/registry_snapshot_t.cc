@@ -0,0 +1,131 @@
+// ======================================================================
+//
+// Check that ParameterSetRegistry snapshots round-trip, and that a
+// mapped snapshot is served by get and has, materializing only what
+// is retrieved.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (registry snapshot test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/detail/registry_snapshot.h"
+#include "fhiclcpp/exception.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+#include "fhiclcpp/test/registry_test_helpers.h"
+
+#include "sqlite3.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace fhicl;
+using fhicl::test::export_registry;
+using fhicl::test::exported_rows;
+using fhicl::test::make_pset;
+namespace fs = std::filesystem;
+
+namespace {
+
+  struct Files {
+    Files()
+    {
+      for (int i = 0; i != 4; ++i) {
+        psets.push_back(make_pset(i));
+      }
+      std::vector<std::pair<ParameterSetID, std::string>> entries;
+      for (auto const& ps : psets) {
+        entries.emplace_back(ps.id(), ps.to_binary_string());
+      }
+      detail::registry_snapshot::write(snapshot.string(), entries);
+    }
+    ~Files()
+    {
+      fs::remove(snapshot);
+      fs::remove(exported);
+    }
+    fs::path const snapshot{fs::temp_directory_path() /
+                            "registry_snapshot_t_1.snap"};
+    fs::path const exported{fs::temp_directory_path() /
+                            "registry_snapshot_t_2.snap"};
+    std::vector<ParameterSet> psets;
+  };
+}
+
+BOOST_FIXTURE_TEST_SUITE(registry_snapshot_test, Files)
+
+BOOST_AUTO_TEST_CASE(snapshot_file)
+{
+  detail::registry_snapshot const s{snapshot.string()};
+  BOOST_TEST(s.size() == psets.size());
+  for (std::size_t i = 1; i < s.size(); ++i) {
+    BOOST_TEST(s.id(i - 1) < s.id(i));
+  }
+  for (auto const& ps : psets) {
+    auto const psBlob = s.find(ps.id());
+    BOOST_TEST_REQUIRE(!psBlob.empty());
+    BOOST_TEST(ParameterSet::make_from_binary(psBlob) == ps);
+  }
+  BOOST_TEST(s.find(make_pset(4).id()).empty());
+
+  std::ofstream{exported} << "not a snapshot";
+  BOOST_CHECK_THROW(detail::registry_snapshot{exported.string()},
+                    fhicl::exception);
+  BOOST_CHECK_THROW(detail::registry_snapshot{"no_such_file.snap"},
+                    fhicl::exception);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_snapshot)
+{
+  BOOST_TEST_REQUIRE(ParameterSetRegistry::empty());
+  ParameterSetRegistry::importSnapshotFrom(snapshot.string());
+
+  // Everything is known, but nothing is materialized...
+  for (auto const& ps : psets) {
+    BOOST_TEST(ParameterSetRegistry::has(ps.id()));
+  }
+  BOOST_TEST(!ParameterSetRegistry::has(make_pset(4).id()));
+  BOOST_TEST(ParameterSetRegistry::empty());
+
+  // ...until it is retrieved.
+  BOOST_TEST(ParameterSetRegistry::get(psets[2].id()) == psets[2]);
+  BOOST_TEST(ParameterSetRegistry::size() == 1u);
+
+  BOOST_TEST(exported_rows() == psets.size());
+
+  // A snapshot of the registry includes what it has mapped, once.
+  ParameterSetRegistry::put(make_pset(4));
+  ParameterSetRegistry::exportSnapshotTo(exported.string());
+  detail::registry_snapshot const s{exported.string()};
+  BOOST_TEST(s.size() == psets.size() + 1);
+  BOOST_TEST(!s.find(make_pset(4).id()).empty());
+
+  ParameterSetRegistry::stageIn();
+  BOOST_TEST(ParameterSetRegistry::size() == psets.size() + 1);
+}
+
+BOOST_AUTO_TEST_CASE(export_after_import)
+{
+  // What is exported from a mapped snapshot is written as text, unless
+  // binary blobs are enabled.
+  ParameterSetRegistry::importSnapshotFrom(snapshot.string());
+  auto const rows = export_registry();
+  BOOST_TEST(rows.size() == psets.size() + 1);
+  for (auto const& row : rows) {
+    BOOST_TEST(row.type == SQLITE_TEXT);
+    BOOST_TEST(ParameterSet::make(row.psBlob).id().to_string() == row.id);
+  }
+
+  ParameterSetRegistry::set_binary_blobs(true);
+  for (auto const& row : export_registry()) {
+    BOOST_TEST(row.type == SQLITE_BLOB);
+  }
+  ParameterSetRegistry::set_binary_blobs(false);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
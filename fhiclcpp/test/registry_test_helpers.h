@@ -0,0 +1,78 @@
+#ifndef fhiclcpp_test_registry_test_helpers_h
+#define fhiclcpp_test_registry_test_helpers_h
+
+// ==================================================================
+// Helpers shared by the tests of ParameterSetRegistry: distinct small
+// ParameterSets, and the rows written by exportTo.
+// ==================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+
+#include "sqlite3.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace fhicl::test {
+
+  // A ParameterSet without nested tables, distinct for each i.
+  inline ParameterSet
+  make_pset(int const i)
+  {
+    ParameterSet result;
+    result.put("i", i);
+    result.put("name", "pset" + std::to_string(i));
+    return result;
+  }
+
+  struct exported_row {
+    std::string id;
+    int type; // SQLITE_TEXT or SQLITE_BLOB
+    std::string psBlob;
+  };
+
+  // The rows written by ParameterSetRegistry::exportTo to a new
+  // in-memory database.  The terminating NUL stored with text is
+  // dropped.
+  inline std::vector<exported_row>
+  export_registry()
+  {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    ParameterSetRegistry::exportTo(db);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(
+      db, "SELECT ID, PSetBlob FROM ParameterSets;", -1, &stmt, nullptr);
+    std::vector<exported_row> result;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      auto const type = sqlite3_column_type(stmt, 1);
+      std::string psBlob{
+        static_cast<char const*>(sqlite3_column_blob(stmt, 1)),
+        static_cast<std::size_t>(sqlite3_column_bytes(stmt, 1))};
+      if (type == SQLITE_TEXT) {
+        psBlob = psBlob.c_str();
+      }
+      result.push_back(
+        {reinterpret_cast<char const*>(sqlite3_column_text(stmt, 0)),
+         type,
+         std::move(psBlob)});
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return result;
+  }
+
+  inline std::size_t
+  exported_rows()
+  {
+    return export_registry().size();
+  }
+}
+
+#endif /* fhiclcpp_test_registry_test_helpers_h */
+
+// Local Variables:
+// mode: c++
+// End:
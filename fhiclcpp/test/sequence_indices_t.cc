@@ -0,0 +1,102 @@
+// ======================================================================
+//
+// Check that detail::get_sequence_indices gives the same results,
+// including errors, as the original regex-based splitting of keys.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (sequence indices test)
+
+#include "boost/test/unit_test.hpp"
+#include "cetlib/split_by_regex.h"
+#include "fhiclcpp/detail/ParameterSetImplHelpers.h"
+
+#include <regex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+using fhicl::detail::get_sequence_indices;
+using fhicl::detail::SequenceKey;
+
+namespace {
+
+  SequenceKey
+  reference_indices(std::string const& key)
+  {
+    static std::regex const reBrackets{R"((\]\[|\[|\]))"};
+    auto tokens = cet::split_by_regex(key, reBrackets);
+    auto const name = tokens.front();
+    tokens.erase(tokens.begin());
+    std::vector<std::size_t> indices;
+    for (auto const& token : tokens) {
+      indices.push_back(std::stoul(token));
+    }
+    return SequenceKey{name, indices};
+  }
+
+  // The outcome of a conversion: either the result or the type and
+  // message of the exception thrown.
+  struct outcome {
+    std::string name;
+    std::vector<std::size_t> indices;
+    std::string error;
+  };
+
+  template <typename F>
+  outcome
+  outcome_of(F f, std::string const& key)
+  {
+    try {
+      auto const skey = f(key);
+      return {skey.name(), skey.indices(), {}};
+    }
+    catch (std::exception const& e) {
+      return {{}, {}, std::string{typeid(e).name()} + ": " + e.what()};
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(sequence_indices_t)
+
+BOOST_AUTO_TEST_CASE(same_as_regex_split)
+{
+  std::vector<std::string> const keys{"a",
+                                      "a_long_parameter_name",
+                                      "a[0]",
+                                      "a[12][3]",
+                                      "a[1][2][3][4][5]",
+                                      "a[007]",
+                                      "[1]",
+                                      "a[",
+                                      "a]",
+                                      "a[]",
+                                      "a[[1]",
+                                      "a[1]]",
+                                      "a]1[",
+                                      "a]][2]",
+                                      "a[1]2",
+                                      "a[1]x",
+                                      "a[x]",
+                                      "a[ 1]",
+                                      "a[1 ]",
+                                      "a[+1]",
+                                      "a[-1]",
+                                      "a[0x10]",
+                                      "a[18446744073709551615]",
+                                      "a[18446744073709551616]",
+                                      "a[99999999999999999999999]",
+                                      "a[999999999999999999]"};
+  for (auto const& key : keys) {
+    BOOST_TEST_CONTEXT("key: " << key)
+    {
+      auto const expected = outcome_of(reference_indices, key);
+      auto const actual = outcome_of(get_sequence_indices, key);
+      BOOST_TEST(actual.name == expected.name);
+      BOOST_TEST(actual.indices == expected.indices);
+      BOOST_TEST(actual.error == expected.error);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
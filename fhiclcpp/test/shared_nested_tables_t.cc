@@ -0,0 +1,103 @@
+// ======================================================================
+//
+// Check that ParameterSets holding their nested tables directly (see
+// ParameterSet::set_shared_nested_tables) behave exactly as those
+// holding them by ID, without registering the nested tables until
+// their IDs are needed.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (shared nested tables test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+  auto const config = R"(
+    a: { b: { c: 1 d: [ 2, 3 ] } e: "a string long enough to be replaced" }
+    s: [ { x: 4 }, { x: 5 y: { z: 6 } } ]
+    f: 7
+  )";
+
+  struct SharedTables {
+    SharedTables() { ParameterSet::set_shared_nested_tables(true); }
+    ~SharedTables() { ParameterSet::set_shared_nested_tables(false); }
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(shared_nested_tables_t)
+
+BOOST_AUTO_TEST_CASE(same_as_registered)
+{
+  auto const reference = ParameterSet::make(config);
+
+  SharedTables const shared;
+  auto const before = ParameterSetRegistry::size();
+  auto const pset = ParameterSet::make(config);
+  BOOST_TEST(ParameterSetRegistry::size() == before);
+
+  BOOST_TEST(pset.id() == reference.id());
+  BOOST_TEST(pset.to_string() == reference.to_string());
+  BOOST_TEST(pset.to_indented_string() == reference.to_indented_string());
+  BOOST_TEST(pset.get_all_keys() == reference.get_all_keys());
+  BOOST_TEST(pset.get_pset_names() == reference.get_pset_names());
+  BOOST_TEST(pset.is_key_to_table("a.b"));
+  BOOST_TEST(pset.get<int>("a.b.c") == 1);
+  BOOST_TEST(pset.get<int>("s[1].y.z") == 6);
+  BOOST_TEST(pset.get<ParameterSet>("a") == reference.get<ParameterSet>("a"));
+  auto const tables = pset.get<std::vector<ParameterSet>>("s");
+  BOOST_TEST_REQUIRE(tables.size() == 2ull);
+  BOOST_TEST(tables[1].get<int>("x") == 5);
+  BOOST_TEST(ParameterSetRegistry::size() == before);
+}
+
+BOOST_AUTO_TEST_CASE(registered_when_id_needed)
+{
+  // Not the tables of 'config', which were registered above.
+  SharedTables const shared;
+  auto const pset = ParameterSet::make(R"(
+    a: { b: { c: 11 } e: "a string long enough to be replaced" }
+    s: [ { x: 14 }, { y: { z: 16 } } ]
+  )");
+  auto const a = pset.get<ParameterSet>("a");
+  BOOST_TEST(!ParameterSetRegistry::has(a.id()));
+
+  // A compact string refers to large nested tables by ID.
+  auto const compact = pset.to_compact_string();
+  BOOST_TEST(compact.find("@id::" + a.id().to_string()) != std::string::npos);
+  BOOST_TEST(ParameterSetRegistry::has(a.id()));
+
+  auto const y = pset.get<ParameterSet>("s[1].y");
+  BOOST_TEST(!ParameterSetRegistry::has(y.id()));
+  BOOST_TEST(pset.get<ParameterSetID>("s[1].y") == y.id());
+  BOOST_TEST(ParameterSetRegistry::get(y.id()) == y);
+}
+
+BOOST_AUTO_TEST_CASE(put_and_copy)
+{
+  SharedTables const shared;
+  ParameterSet child;
+  child.put("x", 1);
+  ParameterSet parent;
+  parent.put("child", child);
+  parent.put("children", std::vector<ParameterSet>{child, child});
+  BOOST_TEST(!ParameterSetRegistry::has(child.id()));
+
+  auto copy = parent;
+  BOOST_TEST(copy.get<ParameterSet>("child") == child);
+  BOOST_TEST(copy.get<int>("children[1].x") == 1);
+  copy.put_or_replace_compatible("child", ParameterSet{});
+  BOOST_TEST(copy.get<ParameterSet>("child").is_empty());
+  BOOST_TEST(parent.get<ParameterSet>("child") == child);
+  BOOST_CHECK_THROW(copy.put_or_replace_compatible("child", 2),
+                    fhicl::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
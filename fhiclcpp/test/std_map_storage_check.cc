@@ -0,0 +1,32 @@
+// ======================================================================
+//
+// Instantiates the ParameterSet inserters and accessors with the
+// std::map backing store (FHICLCPP_STD_MAP_STORAGE), which the default
+// build does not otherwise compile.  Compiled only; never linked.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+  [[maybe_unused]] void
+  instantiate()
+  {
+    fhicl::ParameterSet pset;
+    pset.put("a", 1);
+    pset.put("b", std::vector<int>{1, 2});
+    pset.put("c", std::string{"c"});
+    pset.put_or_replace("a", 2);
+    pset.put_or_replace_compatible("a", 3);
+    pset.put("d", fhicl::ParameterSet{});
+    pset.emplace<std::vector<std::string>>("e", 3, "x");
+    pset.emplace<fhicl::ParameterSet>("f");
+    (void)pset.get<std::vector<int>>("b");
+    (void)pset.get_if_present<int>("d.x");
+    (void)pset.get<fhicl::ParameterSet>("f");
+  }
+}
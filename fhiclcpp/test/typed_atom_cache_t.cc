@@ -0,0 +1,152 @@
+// ======================================================================
+//
+// Check that repeated typed reads of atoms, which are served from the
+// cache held next to each canonical string, give the same results and
+// the same diagnostics as the first read, and that the cache leaves
+// the ParameterSetID untouched.
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (typed atom cache test)
+
+#include "boost/test/unit_test.hpp"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+#include "hep_concurrency/simultaneous_function_spawner.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+  auto const config = R"(
+    i: 42
+    n: -7
+    big: 12345678901
+    f: 1.5
+    inf: +infinity
+    t: true
+    s: "hello"
+    q: "17"
+    seq: [ 1, 2 ]
+    tab: { x: 3 }
+  )";
+
+  // The message of the exception thrown by f, or the empty string.
+  template <typename F>
+  std::string
+  message_of(F f)
+  {
+    try {
+      f();
+    }
+    catch (std::exception const& e) {
+      return e.what();
+    }
+    return {};
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(typed_atom_cache_t)
+
+BOOST_AUTO_TEST_CASE(repeated_reads)
+{
+  auto const pset = ParameterSet::make(config);
+  for (int pass = 0; pass != 3; ++pass) {
+    BOOST_TEST(pset.get<int>("i") == 42);
+    BOOST_TEST(pset.get<unsigned char>("i") == 42u);
+    BOOST_TEST(pset.get<double>("i") == 42.);
+    BOOST_TEST(pset.get<int>("n") == -7);
+    BOOST_TEST(pset.get<long>("big") == 12345678901l);
+    BOOST_TEST(pset.get<std::uintmax_t>("big") == 12345678901ull);
+    BOOST_TEST(pset.get<float>("f") == 1.5f);
+    BOOST_TEST(pset.get<long double>("inf") ==
+               std::numeric_limits<long double>::infinity());
+    BOOST_TEST(pset.get<bool>("t"));
+    BOOST_TEST(pset.get<int>("q") == 17);
+    BOOST_TEST(pset.get<std::string>("s") == "hello");
+    BOOST_TEST(pset.get<std::vector<int>>("seq") == (std::vector<int>{1, 2}));
+    BOOST_TEST(pset.get<int>("seq[1]") == 2);
+    BOOST_TEST(pset.get<int>("tab.x") == 3);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(repeated_failures)
+{
+  auto const pset = ParameterSet::make(config);
+  std::vector<std::function<void()>> const failures{
+    [&pset] { pset.get<int>("f"); },
+    [&pset] { pset.get<unsigned>("n"); },
+    [&pset] { pset.get<short>("big"); },
+    [&pset] { pset.get<int>("inf"); },
+    [&pset] { pset.get<int>("t"); },
+    [&pset] { pset.get<bool>("i"); },
+    [&pset] { pset.get<double>("s"); },
+    [&pset] { pset.get<int>("seq"); },
+    [&pset] { pset.get<bool>("tab"); }};
+  for (auto const& f : failures) {
+    auto const first = message_of(f);
+    BOOST_TEST(!first.empty());
+    BOOST_TEST(message_of(f) == first);
+    // Successful reads of other types do not change the outcome.
+    pset.get<double>("i");
+    pset.get<bool>("t");
+    BOOST_TEST(message_of(f) == first);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(id_unchanged)
+{
+  auto const pset = ParameterSet::make(config);
+  auto const id = pset.id();
+  auto const text = pset.to_string();
+  pset.get<int>("i");
+  pset.get<double>("f");
+  pset.get<bool>("t");
+  BOOST_TEST(pset.to_string() == text);
+  BOOST_TEST(ParameterSet::make(config).id() == id);
+}
+
+BOOST_AUTO_TEST_CASE(copies_and_replacements)
+{
+  auto pset = ParameterSet::make(config);
+  BOOST_TEST(pset.get<int>("i") == 42);
+  auto copy = pset;
+  BOOST_TEST(copy.get<int>("i") == 42);
+
+  pset.put_or_replace("i", 17);
+  BOOST_TEST(pset.get<int>("i") == 17);
+  BOOST_TEST(copy.get<int>("i") == 42);
+
+  copy.put_or_replace_compatible("i", 2.5);
+  BOOST_TEST(copy.get<double>("i") == 2.5);
+  BOOST_CHECK_THROW(copy.get<int>("i"), fhicl::exception);
+
+  pset.erase("t");
+  pset.put("t", false);
+  BOOST_TEST(!pset.get<bool>("t"));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_reads)
+{
+  auto const pset = ParameterSet::make(config);
+  std::atomic<unsigned> mismatches{};
+  auto read = [&pset, &mismatches] {
+    for (int i = 0; i != 100; ++i) {
+      if (pset.get<int>("i") != 42 || pset.get<double>("f") != 1.5 ||
+          !pset.get<bool>("t")) {
+        ++mismatches;
+      }
+    }
+  };
+  std::vector<std::function<void()>> tasks(8, read);
+  hep::concurrency::simultaneous_function_spawner sfs{tasks};
+  BOOST_TEST(mismatches == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 #include "cetlib/parsed_program_options.h"
 #include "cetlib_except/demangle.h"
 #include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
 #include "fhiclcpp/detail/print_mode.h"
 
 #include <iostream>
@@ -38,6 +39,7 @@ namespace {
   struct Options {
     print_mode mode{print_mode::raw};
     bool quiet{false};
+    bool registry_metrics{false};
     string output_filename;
     string input_filename;
     std::unique_ptr<cet::filepath_maker> policy;
@@ -62,17 +64,20 @@ main(int argc, char** argv)
   auto const pset =
     fhicl::ParameterSet::make(opts.input_filename, *opts.policy);
 
-  if (opts.quiet)
-    return 0;
+  if (!opts.quiet) {
+    auto os = cet::select_stream(opts.output_filename, std::cout);
 
-  auto os = cet::select_stream(opts.output_filename, std::cout);
+    os << "# Produced from '" << argv[0] << "' using:\n"
+       << "#   Input  : " << opts.input_filename << '\n'
+       << "#   Policy : "
+       << cet::demangle_symbol(typeid(decltype(*opts.policy)).name()) << '\n'
+       << "#   Path   : \"" << opts.lookup_path << "\"\n\n"
+       << pset.to_indented_string(0, opts.mode);
+  }
 
-  os << "# Produced from '" << argv[0] << "' using:\n"
-     << "#   Input  : " << opts.input_filename << '\n'
-     << "#   Policy : "
-     << cet::demangle_symbol(typeid(decltype(*opts.policy)).name()) << '\n'
-     << "#   Path   : \"" << opts.lookup_path << "\"\n\n"
-     << pset.to_indented_string(0, opts.mode);
+  if (opts.registry_metrics) {
+    fhicl::ParameterSetRegistry::metrics().print(std::cerr);
+  }
 }
 
 //======================================================================
@@ -104,6 +109,10 @@ namespace {
          "include source location annotations on line preceding parameter "
          "assignment (mutually exclusive with 'annotate' option)")
       ("quiet,q", "suppress output to STDOUT")
+      ("registry-metrics",
+         bpo::bool_switch(&opts.registry_metrics),
+         "print ParameterSetRegistry metrics to STDERR (if enabled at build "
+         "time)")
       ("lookup-policy,l",
          bpo::value<string>()->default_value("permissive"), "see --supported-policies")
       ("path,p",
@@ -2,6 +2,7 @@
 #include "cetlib/filepath_maker.h"
 #include "cetlib/parsed_program_options.h"
 #include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
 #include "fhiclcpp/exception.h"
 #include "tools/Printer.h"
 
@@ -29,6 +30,7 @@ namespace {
     std::string sequence_of{};
     bool names_in{false};
     bool allow_missing{false};
+    bool registry_metrics{false};
     std::string parameter_key{};
     std::unique_ptr<cet::filepath_maker> policy;
     std::string lookup_path;
@@ -74,6 +76,8 @@ namespace {
       ("lookup-path",
        bpo::value<std::string>(&opts.lookup_path)->default_value(fhicl_env_var),
        "path or environment variable to be used by lookup-policy")
+      ("registry-metrics", bpo::bool_switch(&opts.registry_metrics),
+       "Print ParameterSetRegistry metrics to STDERR (if enabled at build time).")
       ("supported-types", "list the C++ types supported for by the --atom-as and --sequence-of options.")
       ("supported-policies", "list the supported file lookup policies");
     // clang-format on
@@ -225,6 +229,14 @@ interpreted according to the user-specified command-line.
 
     print_names(pset.get<fhicl::ParameterSet>(key));
   }
+
+#ifdef FHICLCPP_REGISTRY_METRICS
+  void
+  print_registry_metrics(std::ostream& os)
+  {
+    fhicl::ParameterSetRegistry::metrics().print(os);
+  }
+#endif
 }
 
 int
@@ -247,24 +259,20 @@ try {
 
   if (opts.names_in) {
     print_table_names(pset, key, opts.allow_missing);
-    return 0;
-  }
-
-  if (not pset.has_key(key)) {
+  } else if (not pset.has_key(key)) {
     throw cet::exception{config} << "A parameter with the fully-qualified key '"
                                  << key << "' does not exist.";
-  }
-
-  if (not empty(opts.atom_as)) {
+  } else if (not empty(opts.atom_as)) {
     printer_for_types.value_for_atom(pset, opts.atom_as, key);
-    return 0;
-  }
-
-  if (not empty(opts.sequence_of)) {
+  } else if (not empty(opts.sequence_of)) {
     printer_for_types.value_for_sequence(pset, opts.sequence_of, key);
-    return 0;
   }
 
+#ifdef FHICLCPP_REGISTRY_METRICS
+  if (opts.registry_metrics) {
+    print_registry_metrics(std::cerr);
+  }
+#endif
   return 0;
 }
 catch (std::exception const& e) {